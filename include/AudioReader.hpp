@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <memory>
+#include <cstdint>
+#include <span>
+
+namespace libste {
+
+enum class AudioContainer { Wav, Aiff };
+
+struct AudioFormat {
+    AudioContainer container = AudioContainer::Wav;
+    uint32_t sample_rate = 0;
+    uint16_t channels = 0;
+    uint16_t bits_per_sample = 0;  // 8, 16 or 24
+    bool big_endian = false;       // AIFF sample data (unless 'sowt')
+    uint64_t frames = 0;           // From the header; 0 if unknown
+};
+
+// Streaming RIFF WAV / AIFF(-C) PCM reader. The file is walked sequentially
+// (no seeking), so it also works on pipes; samples are decoded block by block
+// into floats in the -1..1 range.
+class AudioReader {
+public:
+    bool open(const std::string& path);   // "-" reads stdin
+    bool open(std::istream& in);
+
+    const AudioFormat& format() const { return format_; }
+
+    // Decodes up to out.size() / channels frames, interleaved. Returns frames read (0 at end).
+    size_t read(std::span<float> out);
+
+    // Decodes up to out.size() frames, downmixed to mono. Returns frames read (0 at end).
+    size_t read_mono(std::span<float> out);
+
+    // Sniffs the first 4 bytes of a file ("RIFF" / "FORM")
+    static bool is_audio_file(const std::string& path);
+
+private:
+    std::unique_ptr<std::istream> file_;
+    std::istream* in_ = nullptr;
+    AudioFormat format_;
+    uint64_t data_remaining_ = 0;  // Bytes left in the sample data chunk
+    std::vector<uint8_t> raw_;
+    std::vector<float> mix_;
+
+    bool parse_wav();
+    bool parse_aiff(bool aifc);
+};
+
+} // namespace libste
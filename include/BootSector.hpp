@@ -0,0 +1,35 @@
+#pragma once
+#include "DiskHandler.hpp"
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace libste {
+
+// Atari boot sector layout: a BRA.S at 0, OEM name and serial, the BPB,
+// then boot code up to the checksum word. TOS runs the code when the
+// sector's big-endian words sum to $1234.
+struct BootSector {
+    static constexpr size_t OEM_OFFSET = 0x02;
+    static constexpr size_t OEM_SIZE = 6;
+    static constexpr size_t SERIAL_OFFSET = 0x08;   // 24 bits, little-endian
+    static constexpr size_t CODE_OFFSET = 0x1E;     // First byte after the BPB
+    static constexpr size_t CHECKSUM_OFFSET = 0x1FE;
+    static constexpr size_t CODE_MAX = CHECKSUM_OFFSET - CODE_OFFSET;  // 480 bytes
+};
+
+// Boot code from a raw binary, or the text and data of a GEMDOS program
+// (which must carry no relocations or BSS, as boot code runs wherever TOS
+// loaded the sector). Fails if the code does not fit after the BPB.
+bool load_boot_code(std::span<const uint8_t> file, std::vector<uint8_t>& code, std::string& error);
+
+// Writes BRA.S to CODE_OFFSET, the code after the BPB (zero-filling the
+// rest) and the checksum. The BPB, OEM name and serial are kept.
+bool install_boot_code(DiskHandler& disk, std::span<const uint8_t> code, std::string& error);
+
+// Space-padded, cut to OEM_SIZE
+void set_oem_name(DiskHandler& disk, const std::string& name);
+void set_serial(DiskHandler& disk, uint32_t serial);
+
+} // namespace libste
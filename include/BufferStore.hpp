@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <span>
+#include <memory>
+#include <iosfwd>
+
+namespace libste {
+
+// Named in-memory files shared by the stages of an in-process pipeline (see
+// the `ste` driver). A path starting with '@' names a buffer instead of a
+// host file; every libste loader and saver and the tools accept both.
+// A stage must not read and write the same buffer.
+bool is_buffer_path(std::string_view path);
+
+// Buffers are viewed in place; host files are read into `storage`
+bool load_input(const std::string& path, std::vector<uint8_t>& storage, std::span<const uint8_t>& data);
+
+// Replaces the buffer or (re)writes the host file
+bool save_output(const std::string& path, std::span<const uint8_t> data);
+
+// Seekable streams over a buffer or a host file; nullptr if it cannot be opened
+std::unique_ptr<std::istream> open_input_stream(const std::string& path);
+std::unique_ptr<std::ostream> open_output_stream(const std::string& path);
+
+void clear_buffers();
+
+} // namespace libste
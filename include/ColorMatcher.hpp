@@ -0,0 +1,83 @@
+#pragma once
+
+#include "StePalette.hpp"
+#include <vector>
+#include <cstdint>
+#include <span>
+#include <atomic>
+#include <mutex>
+
+namespace libste {
+
+struct Lab {
+    float l, a, b;
+};
+
+// sRGB (D65) -> CIELAB
+Lab rgb_to_lab(Rgb8 c);
+
+// Perceptual nearest-colour search over the 4096 STE colours (CIE76 delta E).
+// The 4096 Lab points live in a balanced k-d tree for exact queries. A 64^3
+// RGB grid caches the answer for every cell whose corners agree; the few
+// cells straddling a boundary keep a short candidate list instead. The grid
+// is only built on the first nearest()/remap() call, so exact queries alone
+// cost just the tree.
+class ColorMatcher {
+public:
+    static constexpr int GRID_BITS = 6;
+    static constexpr int GRID_SIZE = 1 << GRID_BITS;
+
+    ColorMatcher();
+
+    // Exact search (k-d tree), returns the STE palette word
+    uint16_t nearest_exact(Rgb8 c) const;
+
+    // O(1) grid lookup, returns the STE palette word. An approximation of
+    // nearest_exact(): a colour whose true match only claims the inside of a
+    // cell (not one of its corners) gets the corners' answer instead.
+    uint16_t nearest(Rgb8 c) const {
+        ensure_grid();
+        return lookup(c);
+    }
+
+    // Batch remap (grid lookups), out.size() must be >= pixels.size()
+    void remap(std::span<const Rgb8> pixels, std::span<uint16_t> out) const;
+
+    // Shared instance, built on first use
+    static const ColorMatcher& instance();
+
+private:
+    static constexpr uint32_t AMBIGUOUS = 0x80000000;
+
+    struct Node {
+        Lab lab;
+        uint16_t word;
+    };
+
+    std::vector<Node> tree_;      // Implicit k-d tree (median at mid of each range)
+    std::vector<Lab> lab_;        // Lab of every STE word
+    // Built lazily, once
+    mutable std::vector<uint32_t> grid_;  // STE word, or AMBIGUOUS | count << 24 | first candidate
+    mutable std::vector<uint16_t> candidates_;
+    mutable std::once_flag grid_once_;
+    mutable std::atomic<bool> grid_ready_{false};
+
+    void ensure_grid() const {
+        if (!grid_ready_.load(std::memory_order_acquire)) build_grid();
+    }
+    void build_grid() const;
+
+    uint16_t lookup(Rgb8 c) const {
+        size_t idx = (size_t(c.r >> (8 - GRID_BITS)) << (2 * GRID_BITS)) |
+                     (size_t(c.g >> (8 - GRID_BITS)) << GRID_BITS) |
+                      size_t(c.b >> (8 - GRID_BITS));
+        uint32_t cell = grid_[idx];
+        return (cell & AMBIGUOUS) ? resolve(c, cell) : static_cast<uint16_t>(cell);
+    }
+
+    void build_tree(size_t begin, size_t end, int depth);
+    uint16_t resolve(Rgb8 c, uint32_t cell) const;
+    void search(size_t begin, size_t end, int depth, const Lab& q, float& best_d, uint16_t& best) const;
+};
+
+} // namespace libste
@@ -0,0 +1,32 @@
+#pragma once
+#include "DiskHandler.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace libste {
+
+struct DefragOptions {
+    // Paths ("AUTO\\INTRO.PRG", '/' works too, any case) laid out first, in
+    // this order; everything else follows in directory order
+    std::vector<std::string> load_order;
+    // Paths whose first cluster must start a track
+    std::vector<std::string> track_aligned;
+};
+
+struct DefragResult {
+    size_t files = 0, directories = 0;
+    size_t extents_before = 0, extents_after = 0;  // Contiguous runs over all chains
+    size_t seeks_before = 0, seeks_after = 0;      // Cylinder changes reading everything in load order
+    size_t clusters_moved = 0;
+};
+
+// Rewrites the image so every file and directory is one contiguous run of
+// clusters, packed from the start of the data area in load order. All moves
+// are planned first as one cluster permutation, which is then applied in
+// place by following its cycles, so every cluster is written exactly once.
+// Directory entries (including "." and "..") and the FATs are rewritten to
+// match. Refuses images st-check would not pass (apart from stale FAT copies).
+bool defragment(DiskHandler& disk, const DefragOptions& options, DefragResult& result, std::string& error);
+
+} // namespace libste
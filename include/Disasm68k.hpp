@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <iosfwd>
+
+namespace libste {
+
+// Writes one line per instruction ("pc: MNEMONIC args") for the 68000 code in `code`.
+// Unknown opcodes are listed as DC.W words.
+void disassemble_68k(std::span<const uint8_t> code, std::ostream& out);
+
+} // namespace libste
@@ -21,6 +21,8 @@ public:
 
     // Raw Sector Access
     std::span<uint8_t> get_sector(size_t sector_index);
+    // `count` consecutive sectors as one span; empty if any lies outside the image
+    std::span<uint8_t> get_sectors(size_t first_sector, size_t count);
     
     // Atari Specifics
     void apply_tos_checksum();
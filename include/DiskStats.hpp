@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <iosfwd>
+
+// Hot-path instrumentation for DiskHandler and Fat12Driver. Configure with
+// -DSTE_STATS=ON to compile the counters in; without it every STE_COUNT and
+// STE_TIME expands to nothing and the snapshot stays zero. The counters are
+// plain globals, so only single-threaded disk work is counted exactly.
+
+namespace libste {
+
+struct DiskStats {
+    uint64_t sector_reads = 0;          // get_sector() / get_sectors() calls
+    uint64_t fat_lookups = 0;           // get_fat_entry()
+    uint64_t fat_updates = 0;           // set_fat_entry()
+    uint64_t fat_mirrors = 0;           // Copies of FAT #1 into the other FATs
+    uint64_t fat_mirror_bytes = 0;
+    uint64_t free_cluster_scans = 0;    // find_free_cluster() calls
+    uint64_t free_cluster_probes = 0;   // FAT entries examined by those scans
+    uint64_t dir_scans = 0;             // Root directory walks
+    uint64_t dir_entries = 0;           // Directory slots examined
+    uint64_t image_bytes_loaded = 0;    // Host I/O for the image itself
+    uint64_t image_bytes_saved = 0;
+    uint64_t file_bytes_read = 0;       // File data copied out of / into the image
+    uint64_t file_bytes_written = 0;
+
+    uint64_t load_ns = 0;
+    uint64_t save_ns = 0;
+    uint64_t dir_scan_ns = 0;
+    uint64_t free_scan_ns = 0;
+    uint64_t extract_ns = 0;
+    uint64_t inject_ns = 0;
+};
+
+constexpr bool stats_enabled() {
+#if STE_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+DiskStats stats_snapshot();
+void reset_stats();
+void print_stats(std::ostream& out, const DiskStats& stats);
+
+// Removes every "--stats" from argv; returns true if there was one
+bool take_stats_flag(int& argc, char* argv[]);
+
+// Resets the counters and prints them to stderr when it goes out of scope
+class StatsReport {
+public:
+    explicit StatsReport(bool enabled);
+    ~StatsReport();
+    StatsReport(const StatsReport&) = delete;
+    StatsReport& operator=(const StatsReport&) = delete;
+
+private:
+    bool enabled_;
+};
+
+#if STE_STATS
+namespace detail {
+
+extern DiskStats g_stats;
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(uint64_t& total) : total_(total), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        total_ += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+private:
+    uint64_t& total_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace detail
+
+#define STE_STATS_CAT2(a, b) a##b
+#define STE_STATS_CAT(a, b) STE_STATS_CAT2(a, b)
+#define STE_COUNT(field, n) (::libste::detail::g_stats.field += (n))
+#define STE_TIME(field) ::libste::detail::ScopedTimer STE_STATS_CAT(ste_timer_, __LINE__)(::libste::detail::g_stats.field)
+#else
+#define STE_COUNT(field, n) ((void)0)
+#define STE_TIME(field) ((void)0)
+#endif
+
+} // namespace libste
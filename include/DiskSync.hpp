@@ -0,0 +1,32 @@
+#pragma once
+#include "DiskHandler.hpp"
+#include <string>
+#include <cstdint>
+
+namespace libste {
+
+struct SyncResult {
+    size_t files = 0, directories = 0;
+    uint64_t bytes = 0;   // File data copied
+    size_t clusters = 0;  // Data clusters written (build: directories included) or read
+};
+
+// Replaces the filesystem on `disk` with the tree under `host_dir`: host
+// names become upper-case 8.3 names (dotfiles are skipped), subdirectories
+// become FAT subdirectories. The whole tree is measured before anything is
+// written, so an oversized tree fails with the image untouched; then every
+// directory and file gets one contiguous run of clusters, in directory order
+// with each subdirectory's contents right after it, and file data is read
+// straight into the image. Boot code and serial are kept, the BPB is reset
+// to 720K, and a bootable image stays bootable.
+bool build_from_tree(DiskHandler& disk, const std::string& host_dir, SyncResult& result, std::string& error);
+
+// Writes every directory and file on the image below `host_dir`. All chains
+// are resolved up front (a broken one fails before anything is written), then
+// `jobs` threads write the files, several at a time; 0 picks one per core.
+// A name that is not a legal 8.3 name (a crafted entry can decode to "..")
+// or a path that resolves outside `host_dir` through a symlink fails it.
+bool extract_to_tree(DiskHandler& disk, const std::string& host_dir, unsigned jobs, SyncResult& result,
+                     std::string& error);
+
+} // namespace libste
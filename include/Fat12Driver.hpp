@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstddef>
 
 namespace libste {
 
@@ -13,18 +14,111 @@ struct DirEntry {
     uint8_t attributes;
 };
 
+// Upper-cases a name and checks it fits 8.3 with TOS-legal characters
+bool to_83(const std::string& host, std::string& name);
+
 class Fat12Driver {
 public:
+    // Fixed 720K layout (the BPB st-mkdisk writes), in sectors
+    static constexpr size_t FAT_START = 1;
+    static constexpr size_t FAT_SECTORS = 5;
+    static constexpr size_t FAT_COPIES = 2;
+    static constexpr size_t ROOT_DIR_START = 11;
+    static constexpr size_t ROOT_DIR_SECTORS = 7;
+    static constexpr size_t DATA_START = 18;
+    static constexpr size_t SECTORS_PER_CLUSTER = 2;
+    static constexpr size_t CLUSTER_SIZE = SECTORS_PER_CLUSTER * DiskHandler::SECTOR_SIZE;
+
+    static constexpr size_t cluster_sector(uint16_t cluster) { return DATA_START + (cluster - 2) * SECTORS_PER_CLUSTER; }
+
     Fat12Driver(DiskHandler& disk);
+    ~Fat12Driver() { flush(); }
+    Fat12Driver(const Fat12Driver&) = delete;
+    Fat12Driver& operator=(const Fat12Driver&) = delete;
     std::vector<DirEntry> list_root_directory();
+    // Entries of the directory starting at `start_cluster` (0 = root), without "." and ".."
+    std::vector<DirEntry> list_directory(uint16_t start_cluster);
+    // Replaces an existing file of the same name in place: its clusters are
+    // reused, extra ones allocated and surplus ones freed. A broken old chain
+    // is freed and the file written to fresh clusters. The name must pass
+    // to_83() and is stored upper-cased, so "a.txt" replaces A.TXT.
     bool inject_file(const std::string& local_path, std::string target_name);
     bool extract_file(const std::string& filename_on_disk, const std::string& local_dest_path);
 
-private:
-    DiskHandler& disk_;
+    // Writes the standard 720K BPB fields (boot code and serial untouched),
+    // zeroed FATs starting with the media byte and an empty root directory
+    void format();
+
+    // Root directory edits. Every name goes through to_83(): it is matched
+    // upper-cased, and one that is not a legal 8.3 name is refused rather
+    // than cut down to one. Delete and truncate refuse directories.
+    bool delete_file(const std::string& filename_on_disk);
+    bool rename_file(const std::string& filename_on_disk, const std::string& new_name);
+    bool truncate_file(const std::string& filename_on_disk, uint32_t new_size);
+
+    // Raw FAT access. Entries are read and written in FAT #1 only (all
+    // FAT_SECTORS of it); the other copies catch up on flush().
     uint16_t get_fat_entry(uint16_t cluster);
     void set_fat_entry(uint16_t cluster, uint16_t value);
     uint16_t find_free_cluster();
+
+    // Frees a chain, following and clearing it in the same walk (a loop ends
+    // at the first cleared cluster). Returns the number of clusters freed.
+    size_t free_chain(uint16_t start);
+
+    // Free data clusters. Counted by one scan on first use, then kept up to
+    // date by set_fat_entry().
+    size_t free_clusters();
+
+    // Mirrors the part of FAT #1 changed since the last flush into every
+    // other copy, one block copy per FAT. Call before saving the image; the
+    // destructor flushes too.
+    void flush();
+
+    // Copies all of FAT #1 over the other copies, e.g. when they disagree
+    void sync_fat_copies();
+
+    // Data clusters are 2 .. cluster_limit() - 1, as far as both the image
+    // and the FAT reach. Entries outside that range read as bad (0xFF7).
+    uint16_t cluster_limit() const;
+
+    // Follows a chain from `start` to its end-of-chain marker, or until it
+    // holds max_length clusters. Returns false (keeping the clusters walked so
+    // far) on a free, reserved, bad or out-of-range link, or on a loop.
+    bool get_chain(uint16_t start, std::vector<uint16_t>& chain, size_t max_length = SIZE_MAX);
+
+    // Caps the FAT lookups and directory slots this driver will touch, so a
+    // hostile image costs bounded work. Once spent, walks stop early and the
+    // operation fails. Unlimited by default.
+    void set_work_budget(uint64_t steps) { budget_ = steps; exhausted_ = false; }
+    bool budget_exhausted() const { return exhausted_; }
+
+private:
+    DiskHandler& disk_;
+    uint64_t budget_ = UINT64_MAX;
+    bool exhausted_ = false;
+    size_t free_count_ = 0;
+    bool free_known_ = false;
+    size_t dirty_begin_ = SIZE_MAX, dirty_end_ = 0;  // Byte range of FAT #1 not yet mirrored
+
+    std::span<uint8_t> fat_copy(size_t copy) {
+        return disk_.get_sectors(FAT_START + copy * FAT_SECTORS, FAT_SECTORS);
+    }
+    void mirror(size_t begin, size_t end);
+
+    // Locates a root directory entry by name; refuses volume labels
+    uint8_t* find_entry(const std::string& filename_on_disk);
+    uint8_t* find_empty_entry();
+
+    bool spend(uint64_t steps) {
+        if (budget_ < steps) {
+            budget_ = 0;
+            exhausted_ = true;
+            return false;
+        }
+        budget_ -= steps;
+        return true;
+    }
 };
 
 } // namespace libste
@@ -0,0 +1,52 @@
+#pragma once
+#include "DiskHandler.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace libste {
+
+enum class FsProblemKind {
+    ImageTooSmall,     // No room for the FATs, root directory and a data area
+    MediaDescriptor,   // FAT entries 0/1 do not match the BPB media byte
+    FatCopyMismatch,   // FAT #2 differs from FAT #1
+    BadStartCluster,   // Directory entry points outside the data area
+    BrokenChain,       // Link to a free, reserved, bad or out-of-range cluster
+    ChainLoop,         // Chain runs back into itself
+    CrossLinked,       // Cluster already owned by another file
+    SizeMismatch,      // Chain length disagrees with the directory size
+    LostClusters       // Allocated in the FAT but owned by no file
+};
+
+struct FsProblem {
+    FsProblemKind kind;
+    std::string path;      // File or directory concerned, empty for FAT-wide problems
+    uint16_t cluster = 0;  // Where it was found, 0 if not tied to one cluster
+    std::string message;   // Readable detail (says what was done when repairing)
+};
+
+struct FsCheckReport {
+    bool boot_checksum_ok = false;  // Only bootable disks need this
+    size_t files = 0, directories = 0;
+    size_t used_clusters = 0, free_clusters = 0, bad_clusters = 0;
+    size_t lost_clusters = 0, lost_chains = 0;
+    std::vector<FsProblem> problems;
+
+    bool clean() const { return problems.empty(); }
+};
+
+const char* to_string(FsProblemKind kind);
+
+// Checks the FAT12 filesystem: FAT copies, the media descriptor, and every
+// directory entry's chain (subdirectories included) against a cluster
+// ownership map built in one pass, so each cluster is followed at most once.
+// Cross-links, loops, broken chains, size mismatches and lost clusters follow
+// from that map.
+//
+// With `repair` the image is fixed as problems are found, as dosfsck does:
+// broken, looping and cross-linked chains end at the last good cluster, sizes
+// are cut to the chain, surplus and lost clusters are freed, and finally
+// FAT #1 (the copy Fat12Driver reads) is mirrored into every other copy.
+FsCheckReport check_filesystem(DiskHandler& disk, bool repair);
+
+} // namespace libste
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <span>
+
+namespace libste {
+
+struct LhaMember {
+    std::string filename;
+    std::string method;      // "-lh0-", "-lh5-" ...
+    uint32_t packed_size;
+    uint32_t original_size;
+    size_t data_offset;      // Offset of the packed data in the archive
+};
+
+// Parses the header of the first member of an LHA archive (levels 0, 1 and 2)
+bool lha_read_header(std::span<const uint8_t> archive, LhaMember& member);
+
+// Unpacks the first member (-lh0- stored, -lh5- static Huffman + LZSS).
+// This is the format .YM music files are distributed in.
+bool lha_depack(std::span<const uint8_t> archive, std::vector<uint8_t>& out);
+
+} // namespace libste
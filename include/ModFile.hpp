@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <span>
+
+namespace libste {
+
+struct ModSample {
+    std::string name;
+    std::vector<int8_t> data;
+    uint32_t loop_start = 0;   // Bytes
+    uint32_t loop_length = 0;  // Bytes, loops only when > 2
+    uint8_t volume = 0;        // 0-64
+    int8_t finetune = 0;       // -8..7
+};
+
+struct ModCell {
+    uint16_t period;
+    uint8_t sample;   // 1-31, 0 = none
+    uint8_t effect;
+    uint8_t param;
+};
+
+// A ProTracker-style module (31 samples, 64-row patterns)
+struct ModSong {
+    std::string title;
+    int channels = 4;
+    ModSample samples[31];
+    std::vector<uint8_t> orders;
+    std::vector<ModCell> cells;  // pattern * 64 * channels + row * channels + channel
+
+    const ModCell& cell(int pattern, int row, int channel) const {
+        return cells[(size_t(pattern) * 64 + row) * channels + channel];
+    }
+};
+
+// Accepts M.K., M!K!, FLT4/FLT8, OCTA and nCHN/nnCH tags
+bool load_mod(std::span<const uint8_t> data, ModSong& song);
+bool load_mod_file(const std::string& path, ModSong& song);
+
+// Checks the format tag at offset 1080
+bool is_mod_file(const std::string& path);
+
+} // namespace libste
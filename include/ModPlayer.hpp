@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ModFile.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace libste {
+
+// ProTracker replay and mixer. Each call renders exactly one replay tick
+// (sample_rate * 2.5 / BPM frames): effects are updated once, then every
+// channel is resampled with a 16.16 fixed-point step and accumulated into
+// 32-bit L/R buffers. Channels pan Amiga-style (L R R L).
+class ModPlayer {
+public:
+    ModPlayer(const ModSong& song, uint32_t sample_rate);
+
+    // Appends one tick of samples (-1..1) to left/right; false once the song ends
+    bool render_tick(std::vector<float>& left, std::vector<float>& right);
+
+    uint32_t sample_rate() const { return rate_; }
+
+private:
+    struct Channel {
+        const ModSample* sample = nullptr;
+        uint64_t pos = 0;          // 16.16 sample position
+        uint32_t step = 0;
+        bool active = false;
+        int volume = 0;
+        int period = 0, target_period = 0, note_period = 0;
+        int finetune = 0;
+        int porta_speed = 0;
+        int vibrato_pos = 0, vibrato_speed = 0, vibrato_depth = 0, vibrato_wave = 0;
+        int tremolo_pos = 0, tremolo_speed = 0, tremolo_depth = 0, tremolo_wave = 0;
+        int offset = 0;
+        int loop_row = 0, loop_count = 0;
+        int out_period = 0, out_volume = 0;  // After vibrato/tremolo/arpeggio
+        ModCell cell{};
+    };
+
+    const ModSong& song_;
+    uint32_t rate_;
+    std::vector<Channel> channels_;
+    int speed_ = 6, tempo_ = 125;
+    int tick_ = 0, row_ = 0, order_ = 0;
+    int next_row_ = -1, next_order_ = -1;
+    int pattern_delay_ = 0;
+    bool loop_jump_ = false;
+    bool ended_ = false;
+    uint32_t tick_remainder_ = 0;
+    std::vector<uint64_t> visited_;      // One 64-bit row mask per order entry
+    std::vector<int32_t> mix_l_, mix_r_;
+    std::vector<int16_t> scratch_;
+
+    void process_row();
+    void advance_row();
+    void trigger(Channel& ch, const ModCell& c);
+    void effect_tick0(Channel& ch);
+    void effect_tick(Channel& ch);
+    void mix(Channel& ch, int index, size_t frames);
+};
+
+} // namespace libste
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <span>
+
+namespace libste {
+
+// Packers for formats with small, fast 68000 depackers
+enum class PackFormat { None, Rle, Lz4 };
+
+// RLE is PackBits (as used by Degas Elite .PC1 and IFF ILBM):
+//   n = 0..127    copy the next n + 1 bytes
+//   n = 129..255  repeat the next byte 257 - n times
+void rle_pack(std::span<const uint8_t> in, std::vector<uint8_t>& out);
+bool rle_depack(std::span<const uint8_t> in, std::vector<uint8_t>& out, size_t original_size);
+
+// LZ4 raw block format (no frame header). Matches come from a 64 KB
+// hash-chain search with one step of lazy evaluation.
+void lz4_pack(std::span<const uint8_t> in, std::vector<uint8_t>& out);
+bool lz4_depack(std::span<const uint8_t> in, std::vector<uint8_t>& out, size_t original_size);
+
+// Dispatch on format (None copies)
+void pack_data(std::span<const uint8_t> in, PackFormat format, std::vector<uint8_t>& out);
+bool depack_data(std::span<const uint8_t> in, PackFormat format, std::vector<uint8_t>& out, size_t original_size);
+
+} // namespace libste
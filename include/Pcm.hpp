@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <string>
+
+namespace libste {
+
+// STE stereo DMA frames are interleaved bytes: L, R, L, R ...
+
+// Interleaves two channels into out (2 * min(left, right) samples)
+template <typename T>
+inline void interleave_stereo(std::span<const T> left, std::span<const T> right, std::span<T> out) {
+    size_t n = std::min({ left.size(), right.size(), out.size() / 2 });
+    const T* l = left.data();
+    const T* r = right.data();
+    T* o = out.data();
+    for (size_t i = 0; i < n; ++i) {
+        o[2 * i] = l[i];
+        o[2 * i + 1] = r[i];
+    }
+}
+
+// Splits interleaved L/R samples into two channels
+template <typename T>
+inline void deinterleave_stereo(std::span<const T> in, std::span<T> left, std::span<T> right) {
+    size_t n = std::min({ in.size() / 2, left.size(), right.size() });
+    const T* s = in.data();
+    T* l = left.data();
+    T* r = right.data();
+    for (size_t i = 0; i < n; ++i) {
+        l[i] = s[2 * i];
+        r[i] = s[2 * i + 1];
+    }
+}
+
+// 8-bit samples (the DMA format) take SSE2/AVX2 paths, see Pcm.cpp
+template <>
+void interleave_stereo<uint8_t>(std::span<const uint8_t> left, std::span<const uint8_t> right, std::span<uint8_t> out);
+template <>
+void deinterleave_stereo<uint8_t>(std::span<const uint8_t> in, std::span<uint8_t> left, std::span<uint8_t> right);
+
+// Unsigned <-> signed 8-bit PCM (WAV <-> STE DMA). Subtracting 128 and
+// adding 128 are the same bit operation: flipping bit 7.
+void flip_pcm_sign(std::span<uint8_t> samples);
+
+// Same transform as above, done in place on a file through mmap (no copy)
+bool flip_pcm_sign_file(const std::string& path);
+
+// Rounds a DMA buffer length up to the frame-buffer alignment (0 = none)
+inline size_t dma_aligned_size(size_t bytes, size_t alignment) {
+    return alignment ? (bytes + alignment - 1) / alignment * alignment : bytes;
+}
+
+} // namespace libste
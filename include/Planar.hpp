@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <iosfwd>
+
+namespace libste {
+
+// Describes how chunky pixels (one byte per pixel) map onto Atari bitplanes.
+struct PlaneLayout {
+    int planes = 4;           // 1 (high res), 2 (medium res), 4 (low res) ... 8
+    bool interleaved = true;  // true: plane words interleaved per 16 pixels (ST screen)
+                              // false: each plane stored as a separate bitmap
+    size_t width = 320;       // Pixels per row (rows are padded to 16 pixels)
+    size_t row_stride = 0;    // Bytes per output row (per plane row if not interleaved), 0 = packed
+
+    size_t groups_per_row() const { return (width + 15) / 16; }
+    size_t stride() const {
+        if (row_stride) return row_stride;
+        return groups_per_row() * 2 * (interleaved ? planes : 1);
+    }
+    // Bytes needed for `rows` rows of output
+    size_t planar_size(size_t rows) const { return stride() * rows * (interleaved ? 1 : planes); }
+};
+
+// Standard ST screen layouts
+inline constexpr PlaneLayout kLowRes    { 4, true, 320, 0 };
+inline constexpr PlaneLayout kMediumRes { 2, true, 640, 0 };
+inline constexpr PlaneLayout kHighRes   { 1, true, 640, 0 };
+
+// Converts `chunky` (layout.width bytes per row) into `planar`.
+// Pixels are masked to the layout's plane count; a short last row is zero padded.
+// Returns false if the layout is invalid or `planar` is smaller than planar_size().
+bool chunky_to_planar(std::span<const uint8_t> chunky, std::span<uint8_t> planar, const PlaneLayout& layout);
+
+// Convenience overload, resizes `planar` to fit.
+bool chunky_to_planar(std::span<const uint8_t> chunky, std::vector<uint8_t>& planar, const PlaneLayout& layout);
+
+// The reverse: bitplanes back to one byte per pixel (layout.width bytes per row).
+// Converts as many whole rows as both buffers hold; returns false if the layout is invalid.
+bool planar_to_chunky(std::span<const uint8_t> planar, std::span<uint8_t> chunky, const PlaneLayout& layout);
+
+// Streams chunky pixels from `in` to `out` in blocks of `block_rows` rows through
+// a reusable double buffer; the next read and the previous write run on a worker
+// thread while the current block converts. Every block is converted on its own,
+// so for plane-major layouts a block is one frame.
+bool stream_chunky_to_planar(std::istream& in, std::ostream& out, const PlaneLayout& layout, size_t block_rows,
+                             uint64_t& pixels_in, uint64_t& bytes_out);
+
+// Pre-shifted sprites: 16 copies shifted right by 0-15 pixels, each one
+// 16 pixels wider than the source, with an AND mask (colour 0 = transparent).
+enum class MaskPlacement {
+    Interleaved,  // Per 16 pixels: mask word, then the plane words
+    Separate      // Interleaved plane words for the frame, then the mask plane
+};
+
+struct SpriteFormat {
+    size_t width = 16;
+    size_t height = 16;
+    int planes = 4;
+    MaskPlacement mask = MaskPlacement::Interleaved;
+
+    size_t shifted_groups() const { return (width + 15) / 16 + 1; }
+    size_t shift_size() const { return shifted_groups() * 2 * (planes + 1) * height; }
+    size_t frame_size() const { return shift_size() * 16; }
+};
+
+// Converts one chunky frame (width * height bytes) into 16 shifted copies.
+// Returns false if the format is invalid or `out` is smaller than frame_size().
+bool preshift_sprite(std::span<const uint8_t> chunky, std::span<uint8_t> out, const SpriteFormat& format);
+
+} // namespace libste
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <span>
+
+namespace libste {
+
+// The Atari STE DMA chip supports 4 specific frequencies
+inline constexpr uint32_t kSteDmaRates[4] = { 6258, 12517, 25033, 50066 };
+
+// Polyphase windowed-sinc (Kaiser) resampler for one mono float stream.
+// The filter bank is computed once in the constructor; process() can be fed
+// arbitrarily sized blocks and keeps the filter history between calls.
+class Resampler {
+public:
+    static constexpr int PHASES = 256;
+    static constexpr uint32_t MAX_RATIO = 256;
+
+    // Both rates non-zero and at most MAX_RATIO apart (the filter length
+    // grows with the decimation ratio)
+    static bool supports(uint32_t in_rate, uint32_t out_rate);
+
+    // zero_crossings sets the filter half-width (quality vs. speed). Rates
+    // that supports() rejects give a resampler that produces nothing.
+    Resampler(uint32_t in_rate, uint32_t out_rate, int zero_crossings = 16);
+
+    bool ok() const { return step_ != 0; }
+
+    // Appends the output produced by `in` to `out`
+    void process(std::span<const float> in, std::vector<float>& out);
+
+    // Drains the filter tail at end of stream
+    void flush(std::vector<float>& out);
+
+    int taps() const { return taps_; }
+
+private:
+    uint32_t in_rate_, out_rate_;
+    int taps_ = 8;             // Filter length (multiple of 8)
+    std::vector<float> bank_;  // (PHASES + 1) x taps_ coefficients
+    std::vector<float> hist_;  // Pending input, starting taps_ - 1 samples before pos_
+    uint64_t pos_ = 0;         // Next output position in input samples, 32.32 fixed point
+    uint64_t step_ = 0;        // in_rate / out_rate, 32.32 fixed point; 0 if unsupported
+    uint64_t consumed_ = 0;    // Input samples dropped from the front of hist_
+    uint64_t produced_ = 0;    // Output samples emitted so far
+    uint64_t fed_ = 0;         // Input samples received so far
+
+    void run(std::vector<float>& out, uint64_t limit);
+};
+
+// Requantizes float samples (-1..1) to STE signed 8-bit, optionally with TPDF dither.
+// `seed` carries the dither generator state between calls.
+void quantize_to_s8(std::span<const float> in, std::span<uint8_t> out, bool dither, uint32_t& seed);
+
+} // namespace libste
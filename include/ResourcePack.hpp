@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Packer.hpp"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <span>
+
+namespace libste {
+
+// One asset inside a resource pack blob. The 68000 side sees the same four
+// longs per entry: offset, size, packed_size, name_hash.
+struct PackEntry {
+    std::string name;           // Path as written in the manifest
+    std::string id;             // Enum identifier
+    uint32_t offset = 0;        // From the start of the blob, aligned
+    uint32_t size = 0;          // Unpacked size
+    uint32_t packed_size = 0;   // 0 = stored as is
+    uint32_t name_hash = 0;
+};
+
+struct ResourcePack {
+    std::vector<PackEntry> entries;
+    std::vector<uint8_t> blob;
+};
+
+struct ManifestItem {
+    std::string path;
+    std::string id;
+};
+
+// 32-bit FNV-1a over the name bytes
+uint32_t asset_name_hash(std::string_view name);
+
+// One asset per line: "<path> [ID]". Blank lines and '#' comments are
+// skipped; a missing ID becomes <prefix>_<FILE_NAME>. Fails on duplicate IDs.
+bool read_manifest(const std::string& path, const std::string& prefix, std::vector<ManifestItem>& items);
+
+// Appends an asset, packed when that makes it smaller, and pads the blob to
+// `align`. Returns false if the packed stream does not depack to the input.
+bool add_pack_asset(ResourcePack& pack, const ManifestItem& item, std::span<const uint8_t> data,
+                    PackFormat format, size_t align);
+
+} // namespace libste
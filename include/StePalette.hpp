@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <span>
+
+namespace libste {
+
+struct Rgb8 {
+    uint8_t r, g, b;
+};
+
+// Convert a 0-15 value to the Atari STE bit order:
+// Atari STE bit 3 is actually moved to the position of bit 0.
+// Expected order in nibble: [Bit 3] [Bit 0] [Bit 1] [Bit 2]
+constexpr uint8_t to_ste_nibble(uint8_t value) {
+    value &= 0x0F;
+    uint8_t bit3 = (value >> 3) & 0x01;
+    uint8_t bits012 = value & 0x07;
+    return static_cast<uint8_t>((bits012 << 1) | bit3);
+}
+
+// Inverse of to_ste_nibble (hardware nibble back to a linear 0-15 level)
+constexpr uint8_t from_ste_nibble(uint8_t nibble) {
+    nibble &= 0x0F;
+    return static_cast<uint8_t>((nibble >> 1) | ((nibble & 0x01) << 3));
+}
+
+// Round an 8-bit channel to the nearest of the 16 STE levels (0, 17, ... 255)
+constexpr uint8_t round_to_ste_level(uint8_t value) {
+    return static_cast<uint8_t>((value * 15 + 127) / 255);
+}
+
+// 8-bit channel -> STE hardware nibble
+inline constexpr std::array<uint8_t, 256> kChannelToSteNibble = [] {
+    std::array<uint8_t, 256> table{};
+    for (int v = 0; v < 256; ++v) {
+        table[v] = to_ste_nibble(round_to_ste_level(static_cast<uint8_t>(v)));
+    }
+    return table;
+}();
+
+// 12-bit STE palette word -> packed 0xRRGGBB
+inline constexpr std::array<uint32_t, 4096> kSteWordToRgb = [] {
+    std::array<uint32_t, 4096> table{};
+    for (uint32_t w = 0; w < 4096; ++w) {
+        uint32_t r = from_ste_nibble((w >> 8) & 0x0F) * 17;
+        uint32_t g = from_ste_nibble((w >> 4) & 0x0F) * 17;
+        uint32_t b = from_ste_nibble(w & 0x0F) * 17;
+        table[w] = (r << 16) | (g << 8) | b;
+    }
+    return table;
+}();
+
+// Combine into a 16-bit word (Atari format: 0RRR 0GGG 0BBB)
+constexpr uint16_t rgb_to_ste_word(Rgb8 c) {
+    return static_cast<uint16_t>((kChannelToSteNibble[c.r] << 8) |
+                                 (kChannelToSteNibble[c.g] << 4) |
+                                  kChannelToSteNibble[c.b]);
+}
+
+constexpr Rgb8 ste_word_to_rgb(uint16_t word) {
+    uint32_t rgb = kSteWordToRgb[word & 0x0FFF];
+    return { static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb) };
+}
+
+enum class PaletteFormat {
+    Auto,   // Sniff the header (GIMP / JASC), otherwise a hex list
+    Hex,    // Whitespace separated #RRGGBB / RRGGBB / 0xRRGGBB
+    Gimp,   // GIMP .gpl
+    Jasc    // JASC-PAL (Paint Shop Pro .pal)
+};
+
+enum class PaletteEmit {
+    Hex,    // One $0RGB word per line
+    Asm,    // DC.W blocks for Devpac/vasm
+    CArray, // const unsigned short name[] = { ... };
+    Gimp    // GIMP .gpl (reverse direction only)
+};
+
+// Parsing
+bool parse_hex_rgb(std::string_view text, Rgb8& out);
+bool parse_ste_word(std::string_view text, uint16_t& out);
+bool read_palette(std::string_view text, PaletteFormat format, std::vector<Rgb8>& out);
+bool read_ste_words(std::string_view text, std::vector<uint16_t>& out);
+
+// Batch Conversion
+std::vector<uint16_t> palette_to_ste(std::span<const Rgb8> colors);
+std::vector<Rgb8> ste_to_palette(std::span<const uint16_t> words);
+
+// Emission (appends to out)
+void emit_ste_words(std::span<const uint16_t> words, PaletteEmit style, const std::string& name, std::string& out);
+void emit_rgb_palette(std::span<const Rgb8> colors, PaletteEmit style, const std::string& name, std::string& out);
+
+} // namespace libste
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <ostream>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace libste {
+
+// Streaming RIFF/WAV writer. A placeholder header goes out first, sample
+// blocks are appended as they arrive, and close() patches the sizes. The
+// header reserves a JUNK chunk that becomes a ds64 chunk (RF64) once the
+// data passes 4 GB. All fields are serialized little-endian explicitly.
+// Writing to "-" (stdout) works too; the sizes are then left as 0xFFFFFFFF.
+// "@name" writes to an in-process buffer (see BufferStore.hpp).
+class WavWriter {
+public:
+    ~WavWriter();
+
+    bool open(const std::string& path, uint32_t sample_rate, uint16_t channels, uint16_t bits_per_sample);
+
+    // Appends PCM already in WAV byte order (8-bit unsigned, 16-bit little-endian)
+    bool write(std::span<const uint8_t> pcm);
+
+    // Appends 16-bit samples, serialized little-endian
+    bool write(std::span<const int16_t> samples);
+
+    // Patches the header sizes and closes the file
+    bool close();
+
+    uint64_t data_bytes() const { return data_bytes_; }
+
+private:
+    std::unique_ptr<std::ostream> file_;
+    std::ostream* out_ = nullptr;
+    bool seekable_ = false;
+    uint32_t sample_rate_ = 0;
+    uint16_t channels_ = 0, bits_ = 0;
+    uint64_t data_bytes_ = 0;
+    std::vector<uint8_t> scratch_;
+
+    std::vector<uint8_t> build_header(bool rf64) const;
+};
+
+} // namespace libste
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace libste {
+
+// YM2149 PSG emulation: three square-wave tone generators, the 17-bit LFSR
+// noise generator, the 32-step envelope generator and the logarithmic DAC.
+// Time advances in integer ticks of master_clock / 8; render() jumps from one
+// generator edge to the next and box-filters each output sample.
+class Ym2149 {
+public:
+    Ym2149(uint32_t master_clock, uint32_t sample_rate);
+
+    void write(int reg, uint8_t value);
+
+    // Applies one YM dump frame (register 13 = 0xFF leaves the envelope running)
+    void load_frame(const std::array<uint8_t, 16>& regs);
+
+    // Renders signed 16-bit mono samples
+    void render(std::span<int16_t> out);
+
+private:
+    uint8_t regs_[16] = {};
+    uint32_t step_;               // Ticks per output sample, 16.16 fixed point
+    uint32_t frac_ = 0;
+
+    uint32_t tone_period_[3] = { 1, 1, 1 };
+    uint32_t tone_count_[3] = {};
+    uint8_t tone_out_[3] = {};
+
+    uint32_t noise_period_ = 2;
+    uint32_t noise_count_ = 0;
+    uint32_t rng_ = 1;
+    uint8_t noise_out_ = 0;
+
+    uint32_t env_period_ = 1;
+    uint32_t env_count_ = 0;
+    int env_step_ = 0x1F;
+    uint8_t env_attack_ = 0;
+    bool env_hold_ = false, env_alternate_ = false, env_holding_ = false;
+
+    float dc_in_ = 0.0f, dc_out_ = 0.0f;  // DC blocker (the DAC output is unipolar)
+
+    float level() const;
+    void advance_envelope();
+};
+
+} // namespace libste
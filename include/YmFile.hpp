@@ -0,0 +1,24 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <span>
+
+namespace libste {
+
+// A YM2149 register dump: one set of 16 register values per player frame
+struct YmSong {
+    uint32_t master_clock = 2000000;  // Atari ST PSG clock
+    uint16_t frame_rate = 50;
+    uint32_t loop_frame = 0;
+    std::string name, author, comment;
+    std::vector<std::array<uint8_t, 16>> frames;
+};
+
+// Parses YM2!, YM3!, YM3b, YM5! and YM6! dumps, unpacking LHA (-lh5-) first if needed
+bool load_ym(std::span<const uint8_t> data, YmSong& song);
+bool load_ym_file(const std::string& path, YmSong& song);
+
+} // namespace libste
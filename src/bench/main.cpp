@@ -0,0 +1,319 @@
+// ste-bench: throughput of the ste_core hot paths on synthetic data.
+// Reports ns/op and MB/s per benchmark; --json writes the same numbers in a
+// stable form so two builds can be diffed.
+#include "DiskHandler.hpp"
+#include "Fat12Driver.hpp"
+#include "BufferStore.hpp"
+#include "Planar.hpp"
+#include "Disasm68k.hpp"
+#include "Packer.hpp"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <cstdint>
+
+using namespace libste;
+
+namespace {
+
+// Keeps the optimizer from discarding a result
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Discards everything written to it
+class NullBuf : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// Small deterministic generator so every build sees the same data
+struct Lcg {
+    uint32_t state = 0x5EED1234;
+    uint32_t next() { return state = state * 1664525u + 1013904223u; }
+};
+
+struct Benchmark {
+    std::string name;
+    size_t bytes_per_op;             // 0 = no MB/s figure
+    std::function<void()> setup;     // Runs once before timing, may be empty
+    std::function<void(size_t)> run; // Runs the operation n times
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations;
+    double ns_per_op;
+    double mb_per_s;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_for(const Benchmark& bench, size_t n) {
+    auto t0 = Clock::now();
+    bench.run(n);
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Grows the batch until it runs for min_time, then keeps the median of `reps` batches
+Result measure(const Benchmark& bench, double min_time, int reps) {
+    if (bench.setup) bench.setup();
+    size_t n = 1;
+    double t = seconds_for(bench, n);
+    while (t < min_time / 10 && n < (size_t(1) << 40)) {
+        n *= 2;
+        t = seconds_for(bench, n);
+    }
+    n = std::max<size_t>(1, static_cast<size_t>(n * (min_time / std::max(t, 1e-9))));
+
+    std::vector<double> times;
+    for (int r = 0; r < reps; ++r) times.push_back(seconds_for(bench, n));
+    std::sort(times.begin(), times.end());
+    double best = times[times.size() / 2];
+
+    Result result{ bench.name, n, best * 1e9 / n, 0.0 };
+    if (bench.bytes_per_op) result.mb_per_s = (double(bench.bytes_per_op) * n / 1e6) / best;
+    return result;
+}
+
+// --- Synthetic inputs ---
+
+// A formatted 720 KB disk: empty FAT and root directory, boot checksum applied
+void format_disk(DiskHandler& disk) {
+    disk.create_blank();
+    for (size_t s = 1; s <= 17; ++s) {
+        auto sector = disk.get_sector(s);
+        std::memset(sector.data(), 0, sector.size());
+    }
+    auto fat = disk.get_sector(1);
+    fat[0] = 0xF9; fat[1] = 0xFF; fat[2] = 0xFF;
+    disk.apply_tos_checksum();
+}
+
+std::vector<uint8_t> random_bytes(size_t n, Lcg& rng) {
+    std::vector<uint8_t> v(n);
+    for (auto& b : v) b = static_cast<uint8_t>(rng.next() >> 24);
+    return v;
+}
+
+// Chunky pixels with horizontal runs, roughly what a drawn screen looks like
+std::vector<uint8_t> synthetic_screen(size_t pixels, int colours, Lcg& rng) {
+    std::vector<uint8_t> v(pixels);
+    size_t i = 0;
+    while (i < pixels) {
+        size_t run = 1 + (rng.next() >> 28);
+        uint8_t c = static_cast<uint8_t>((rng.next() >> 20) % colours);
+        for (; run && i < pixels; --run) v[i++] = c;
+    }
+    return v;
+}
+
+// A mix of the opcodes st-disasm decodes and words it falls back on
+std::vector<uint8_t> synthetic_code(size_t n, Lcg& rng) {
+    std::vector<uint8_t> v;
+    v.reserve(n + 6);
+    while (v.size() < n) {
+        uint32_t r = rng.next();
+        uint16_t op;
+        switch ((r >> 28) & 3) {
+            case 0: op = 0x4E71; break;                                    // NOP
+            case 1: op = static_cast<uint16_t>(0x1000 | ((r >> 8) & 0x0FFF)); break; // MOVE.B
+            case 2: op = static_cast<uint16_t>(0x41F9 | (((r >> 8) & 7) << 9)); break; // LEA abs.L
+            default: op = static_cast<uint16_t>(r >> 8); break;
+        }
+        v.push_back(static_cast<uint8_t>(op >> 8));
+        v.push_back(static_cast<uint8_t>(op));
+        if ((op & 0xF1FF) == 0x41F9) {
+            for (int i = 0; i < 4; ++i) v.push_back(static_cast<uint8_t>(rng.next() >> 24));
+        }
+    }
+    v.resize(n);
+    return v;
+}
+
+struct Fixtures {
+    Lcg rng;
+    DiskHandler disk;          // 112 root entries, FAT ~97% used
+    DiskHandler sparse_disk;   // One 64 KB file
+    std::vector<uint8_t> low_chunky, med_chunky, high_chunky;
+    std::vector<uint8_t> low_planar, planar_out, chunky_out;
+    std::vector<uint8_t> sprite, sprite_out;
+    std::vector<uint8_t> code;
+    std::vector<uint8_t> packed_lz4, pack_out;
+
+    Fixtures() {
+        low_chunky = synthetic_screen(320 * 200, 16, rng);
+        med_chunky = synthetic_screen(640 * 200, 4, rng);
+        high_chunky = synthetic_screen(640 * 400, 2, rng);
+        chunky_to_planar(low_chunky, low_planar, kLowRes);
+        sprite = synthetic_screen(32 * 32, 16, rng);
+        code = synthetic_code(64 * 1024, rng);
+        lz4_pack(low_chunky, packed_lz4);
+
+        format_disk(sparse_disk);
+        save_output("@bench_file", random_bytes(64 * 1024, rng));
+        Fat12Driver(sparse_disk).inject_file("@bench_file", "DATA.BIN");
+
+        format_disk(disk);
+        Fat12Driver fat(disk);
+        save_output("@bench_small", random_bytes(4000, rng));
+        for (int i = 0; i < 112; ++i) fat.inject_file("@bench_small", "FILE" + std::to_string(i) + ".DAT");
+        // 112 files x 4 clusters leave 263 of the 711 data clusters free;
+        // fill all but the last 40 so find_free_cluster scans most of the FAT
+        const uint16_t limit = fat.cluster_limit();
+        for (uint16_t c = 2; c < limit - 40; ++c) {
+            if (fat.get_fat_entry(c) == 0) fat.set_fat_entry(c, 0xFFF);
+        }
+    }
+};
+
+std::vector<Benchmark> make_benchmarks(Fixtures& fx) {
+    std::vector<Benchmark> list;
+
+    list.push_back({ "disk/verify_tos_checksum", DiskHandler::SECTOR_SIZE, {}, [&fx](size_t n) {
+        for (size_t i = 0; i < n; ++i) keep(fx.disk.verify_tos_checksum());
+    } });
+
+    list.push_back({ "fat/get_fat_entry", 0, {}, [&fx](size_t n) {
+        Fat12Driver fat(fx.disk);
+        const uint16_t limit = fat.cluster_limit();
+        uint16_t c = 2;
+        for (size_t i = 0; i < n; ++i) {
+            keep(fat.get_fat_entry(c));
+            if (++c == limit) c = 2;
+        }
+    } });
+
+    list.push_back({ "fat/find_free_cluster", 0, {}, [&fx](size_t n) {
+        Fat12Driver fat(fx.disk);
+        for (size_t i = 0; i < n; ++i) keep(fat.find_free_cluster());
+    } });
+
+    list.push_back({ "fat/list_root_directory", 7 * DiskHandler::SECTOR_SIZE, {}, [&fx](size_t n) {
+        Fat12Driver fat(fx.disk);
+        for (size_t i = 0; i < n; ++i) keep(fat.list_root_directory().size());
+    } });
+
+    list.push_back({ "fat/extract_file_64k", 64 * 1024, {}, [&fx](size_t n) {
+        Fat12Driver fat(fx.sparse_disk);
+        for (size_t i = 0; i < n; ++i) keep(fat.extract_file("DATA.BIN", "@bench_out"));
+    } });
+
+    struct C2p { const char* name; std::vector<uint8_t>* chunky; PlaneLayout layout; };
+    for (C2p c : { C2p{ "video/chunky_to_planar_low", &fx.low_chunky, kLowRes },
+                   C2p{ "video/chunky_to_planar_medium", &fx.med_chunky, kMediumRes },
+                   C2p{ "video/chunky_to_planar_high", &fx.high_chunky, kHighRes } }) {
+        list.push_back({ c.name, c.chunky->size(),
+            [&fx, c] { fx.planar_out.assign(c.layout.planar_size(c.chunky->size() / c.layout.width), 0); },
+            [&fx, c](size_t n) {
+                for (size_t i = 0; i < n; ++i) {
+                    keep(chunky_to_planar(*c.chunky, std::span<uint8_t>(fx.planar_out), c.layout));
+                }
+            } });
+    }
+
+    // The pi1-to-png deplanarizer
+    list.push_back({ "video/planar_to_chunky_low", 32000, [&fx] { fx.chunky_out.assign(320 * 200, 0); },
+        [&fx](size_t n) {
+            for (size_t i = 0; i < n; ++i) keep(planar_to_chunky(fx.low_planar, fx.chunky_out, kLowRes));
+        } });
+
+    list.push_back({ "video/preshift_sprite_32x32", 32 * 32, {}, [&fx](size_t n) {
+        SpriteFormat format{ 32, 32, 4, MaskPlacement::Interleaved };
+        fx.sprite_out.resize(format.frame_size());
+        for (size_t i = 0; i < n; ++i) keep(preshift_sprite(fx.sprite, fx.sprite_out, format));
+    } });
+
+    list.push_back({ "code/disassemble_68k_64k", 64 * 1024, {}, [&fx](size_t n) {
+        NullBuf sink;
+        std::ostream out(&sink);
+        for (size_t i = 0; i < n; ++i) disassemble_68k(fx.code, out);
+    } });
+
+    list.push_back({ "pack/rle_pack_screen", 320 * 200, {}, [&fx](size_t n) {
+        for (size_t i = 0; i < n; ++i) rle_pack(fx.low_chunky, fx.pack_out);
+    } });
+
+    list.push_back({ "pack/lz4_pack_screen", 320 * 200, {}, [&fx](size_t n) {
+        for (size_t i = 0; i < n; ++i) lz4_pack(fx.low_chunky, fx.pack_out);
+    } });
+
+    list.push_back({ "pack/lz4_depack_screen", 320 * 200, {}, [&fx](size_t n) {
+        for (size_t i = 0; i < n; ++i) keep(lz4_depack(fx.packed_lz4, fx.pack_out, 320 * 200));
+    } });
+
+    return list;
+}
+
+void write_json(std::ostream& out, const std::vector<Result>& results, double min_time, int reps) {
+    out << "{\n  \"min_time\": " << min_time << ",\n  \"repetitions\": " << reps << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    { \"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << std::fixed << std::setprecision(2) << r.ns_per_op
+            << ", \"mb_per_s\": " << r.mb_per_s << std::defaultfloat << " }"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter, json_path;
+    double min_time = 0.2;
+    int reps = 5;
+    bool list_only = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--json" && i + 1 < argc) json_path = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc) min_time = std::stod(argv[++i]);
+        else if (arg == "--reps" && i + 1 < argc) reps = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--list") list_only = true;
+        else {
+            std::cout << "Usage: ste-bench [--filter substr] [--min-time sec] [--reps n] [--json file|-] [--list]\n";
+            return 1;
+        }
+    }
+
+    Fixtures fixtures;
+    std::vector<Result> results;
+    for (const auto& bench : make_benchmarks(fixtures)) {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos) continue;
+        if (list_only) {
+            std::cout << bench.name << "\n";
+            continue;
+        }
+        Result r = measure(bench, min_time, reps);
+        std::cout << std::left << std::setw(34) << r.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << r.ns_per_op << " ns/op";
+        if (r.mb_per_s > 0) std::cout << std::setw(12) << r.mb_per_s << " MB/s";
+        std::cout << std::defaultfloat << "\n";
+        results.push_back(r);
+    }
+    clear_buffers();
+
+    if (!json_path.empty() && !list_only) {
+        if (json_path == "-") {
+            write_json(std::cout, results, min_time, reps);
+        } else {
+            std::ofstream out(json_path);
+            write_json(out, results, min_time, reps);
+            if (!out) {
+                std::cerr << "Error: Could not write " << json_path << "\n";
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+
+// Shared bits of the fuzz harnesses. Each harness is a libFuzzer entry point
+// (also what AFL++ builds with -fsanitize=fuzzer); StandaloneMain.cpp replays
+// corpus files through the same entry point on compilers without libFuzzer.
+
+// Aborts (so the fuzzer records a crash) when a bound is broken, even in release builds
+#define FUZZ_CHECK(cond)                                                             \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": FUZZ_CHECK(" #cond ") failed\n"; \
+            std::abort();                                                            \
+        }                                                                            \
+    } while (0)
+
+// Silences a tool's chatter on std::cout for the lifetime of the object
+class QuietCout {
+public:
+    QuietCout() : saved_(std::cout.rdbuf(&sink_)) {}
+    ~QuietCout() { std::cout.rdbuf(saved_); }
+
+private:
+    struct NullBuf : std::streambuf {
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    } sink_;
+    std::streambuf* saved_;
+};
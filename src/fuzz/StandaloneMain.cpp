@@ -0,0 +1,61 @@
+// Replays inputs through LLVMFuzzerTestOneInput without libFuzzer, so crashes
+// and corpora can be checked with GCC builds (and sanitizers) too.
+//   fuzz-<name> [--max-ms n] <file|dir>...
+// --max-ms fails the run if any single input takes longer than n milliseconds.
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace fs = std::filesystem;
+
+static bool run_file(const fs::path& path, double max_ms, double& worst_ms) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto t0 = std::chrono::steady_clock::now();
+    LLVMFuzzerTestOneInput(data.data(), data.size());
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    worst_ms = std::max(worst_ms, ms);
+    if (max_ms > 0 && ms > max_ms) {
+        std::cerr << path.string() << ": took " << ms << " ms (limit " << max_ms << " ms)\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    double max_ms = 0;
+    std::vector<fs::path> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-ms" && i + 1 < argc) max_ms = std::stod(argv[++i]);
+        else inputs.emplace_back(arg);
+    }
+    if (inputs.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--max-ms n] <file|dir>...\n";
+        return 1;
+    }
+
+    size_t count = 0;
+    double worst_ms = 0;
+    bool ok = true;
+    for (const auto& input : inputs) {
+        if (fs::is_directory(input)) {
+            for (const auto& entry : fs::recursive_directory_iterator(input)) {
+                if (!entry.is_regular_file()) continue;
+                ok = run_file(entry.path(), max_ms, worst_ms) && ok;
+                ++count;
+            }
+        } else {
+            ok = run_file(input, max_ms, worst_ms) && ok;
+            ++count;
+        }
+    }
+    std::cerr << count << " inputs, slowest " << worst_ms << " ms\n";
+    return ok ? 0 : 1;
+}
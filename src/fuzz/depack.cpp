@@ -0,0 +1,25 @@
+// Arbitrary bytes through the RLE and LZ4 depackers, and through a pack/depack round trip
+#include "Fuzz.hpp"
+#include "Packer.hpp"
+#include <vector>
+#include <span>
+#include <algorithm>
+
+using namespace libste;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 4) return 0;
+    // Header: format byte, then a 20-bit claimed original size
+    PackFormat format = (data[0] & 1) ? PackFormat::Lz4 : PackFormat::Rle;
+    size_t claimed = ((data[1] | (data[2] << 8) | (data[3] << 16)) & 0xFFFFF);
+    std::span<const uint8_t> body(data + 4, size - 4);
+
+    std::vector<uint8_t> out;
+    if (depack_data(body, format, out, claimed)) FUZZ_CHECK(out.size() == claimed);
+
+    std::vector<uint8_t> packed;
+    pack_data(body, format, packed);
+    FUZZ_CHECK(depack_data(packed, format, out, body.size()));
+    FUZZ_CHECK(std::equal(out.begin(), out.end(), body.begin(), body.end()));
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Arbitrary bytes as a disk image: list the root directory, extract every
+// entry, walk every chain, inject one file back and one over an existing
+// name, then repair and defragment.
+// The work budget proves the walks stay bounded whatever the FAT and
+// directory contain.
+#include "Fuzz.hpp"
+#include "DiskHandler.hpp"
+#include "Fat12Driver.hpp"
+#include "BufferStore.hpp"
+#include "FsCheck.hpp"
+#include "Defrag.hpp"
+#include <vector>
+#include <span>
+#include <algorithm>
+
+using namespace libste;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    // Bigger images only repeat the same paths
+    if (size > 2 * 1024 * 1024) return 0;
+    save_output("@image", std::span<const uint8_t>(data, size));
+
+    DiskHandler disk;
+    FUZZ_CHECK(disk.load_from_file("@image"));
+    Fat12Driver fs(disk);
+
+    // Every root slot once, then per entry an extract (a directory scan plus
+    // one chain walk) and a separate chain walk
+    constexpr uint64_t kSlots = 7 * 16;
+    const uint64_t limit = fs.cluster_limit();
+    fs.set_work_budget(kSlots + kSlots * (kSlots + 2 * limit));
+
+    auto entries = fs.list_root_directory();
+    FUZZ_CHECK(entries.size() <= kSlots);
+
+    std::vector<uint8_t> storage;
+    std::span<const uint8_t> out;
+    std::vector<uint16_t> chain;
+    for (const auto& entry : entries) {
+        if (fs.extract_file(entry.filename, "@out")) {
+            FUZZ_CHECK(load_input("@out", storage, out));
+            FUZZ_CHECK(out.size() <= limit * 1024);
+        }
+        fs.get_chain(entry.start_cluster, chain);
+        FUZZ_CHECK(chain.size() < limit);
+    }
+    FUZZ_CHECK(!fs.budget_exhausted());
+
+    // Round trip through whatever allocator state the image has
+    bool name_taken = std::any_of(entries.begin(), entries.end(), [](const DirEntry& e) {
+        return e.filename == "FUZZ.BIN";
+    });
+    std::vector<uint8_t> payload(3000);
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<uint8_t>(i * 7);
+    save_output("@payload", payload);
+    // Inject: a name lookup, a slot search, the free count and one allocation
+    // scan; extract: as above; delete: a name lookup and the three clusters
+    fs.set_work_budget(4 * kSlots + 3 * limit + 3);
+    if (!name_taken && fs.inject_file("@payload", "FUZZ.BIN")) {
+        FUZZ_CHECK(fs.extract_file("FUZZ.BIN", "@out"));
+        FUZZ_CHECK(load_input("@out", storage, out));
+        FUZZ_CHECK(std::equal(out.begin(), out.end(), payload.begin(), payload.end()));
+        // Deleting it gives back exactly the clusters it took
+        size_t free_with = fs.free_clusters();
+        FUZZ_CHECK(fs.delete_file("FUZZ.BIN"));
+        FUZZ_CHECK(fs.free_clusters() == free_with + 3);
+    }
+
+    FUZZ_CHECK(!fs.budget_exhausted());
+
+    // Replace an existing file: its chain (intact, broken or pointing out of
+    // range) is reused or released. Inject: a name lookup, the old chain, the
+    // free count, a release and one allocation scan; extract: as above.
+    auto victim = std::find_if(entries.begin(), entries.end(), [](const DirEntry& e) {
+        return !(e.attributes & 0x18) && e.filename != "FUZZ.BIN";
+    });
+    if (victim != entries.end()) {
+        fs.set_work_budget(4 * kSlots + 5 * limit + 8);
+        if (fs.inject_file("@payload", victim->filename)) {
+            FUZZ_CHECK(fs.extract_file(victim->filename, "@out"));
+            FUZZ_CHECK(load_input("@out", storage, out));
+            FUZZ_CHECK(std::equal(out.begin(), out.end(), payload.begin(), payload.end()));
+        }
+    }
+
+    // One repair pass must leave nothing for a second check to find
+    check_filesystem(disk, true);
+    FsCheckReport after = check_filesystem(disk, false);
+    if (!after.clean() && after.problems[0].kind != FsProblemKind::ImageTooSmall) {
+        for (const auto& p : after.problems) std::cerr << to_string(p.kind) << ": " << p.path << " " << p.message << "\n";
+    }
+    FUZZ_CHECK(after.clean() || after.problems[0].kind == FsProblemKind::ImageTooSmall);
+
+    // ...and a repaired image defragments into one that still checks clean
+    if (after.clean()) {
+        DefragResult result;
+        std::string error;
+        FUZZ_CHECK(defragment(disk, DefragOptions{}, result, error));
+        FUZZ_CHECK(result.extents_after <= result.files + result.directories);
+        FUZZ_CHECK(check_filesystem(disk, false).clean());
+    }
+    clear_buffers();
+    return 0;
+}
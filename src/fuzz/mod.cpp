@@ -0,0 +1,26 @@
+// Arbitrary bytes as a ProTracker module, replayed for a bounded number of ticks
+#include "Fuzz.hpp"
+#include "ModFile.hpp"
+#include "ModPlayer.hpp"
+#include <vector>
+#include <span>
+
+using namespace libste;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    ModSong song;
+    if (!load_mod(std::span<const uint8_t>(data, size), song)) return 0;
+
+    constexpr uint32_t kRate = 8000;
+    ModPlayer player(song, kRate);
+    std::vector<float> left, right;
+    for (int tick = 0; tick < 512; ++tick) {
+        size_t before = left.size();
+        if (!player.render_tick(left, right)) break;
+        // One tick is rate * 2.5 / BPM frames, and BPM is at least 32
+        FUZZ_CHECK(left.size() - before <= kRate * 5 / 64 + 1);
+        left.clear();
+        right.clear();
+    }
+    return 0;
+}
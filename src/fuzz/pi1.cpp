@@ -0,0 +1,18 @@
+// Arbitrary bytes through the pi1-to-png reader (its main(), built in as pi1_to_png_main)
+#include "Fuzz.hpp"
+#include "BufferStore.hpp"
+#include <span>
+
+int pi1_to_png_main(int argc, char* argv[]);
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    libste::save_output("@in.pi1", std::span<const uint8_t>(data, size));
+    char tool[] = "pi1-to-png", in[] = "@in.pi1", out[] = "@out.png";
+    char* argv[] = { tool, in, out, nullptr };
+    {
+        QuietCout quiet;
+        FUZZ_CHECK(pi1_to_png_main(3, argv) == 0);
+    }
+    libste::clear_buffers();
+    return 0;
+}
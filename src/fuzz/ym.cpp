@@ -0,0 +1,25 @@
+// Arbitrary bytes as a .YM file (raw or LHA packed), plus the first frames through the PSG
+#include "Fuzz.hpp"
+#include "YmFile.hpp"
+#include "Ym2149.hpp"
+#include <vector>
+#include <span>
+#include <algorithm>
+
+using namespace libste;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    YmSong song;
+    if (!load_ym(std::span<const uint8_t>(data, size), song)) return 0;
+    FUZZ_CHECK(!song.frames.empty());
+
+    constexpr uint32_t kRate = 8000;
+    Ym2149 psg(song.master_clock, kRate);
+    std::vector<int16_t> samples(kRate / song.frame_rate + 1);
+    size_t frames = std::min<size_t>(song.frames.size(), 16);
+    for (size_t f = 0; f < frames; ++f) {
+        psg.load_frame(song.frames[f]);
+        psg.render(samples);
+    }
+    return 0;
+}
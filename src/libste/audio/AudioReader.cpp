@@ -0,0 +1,226 @@
+#include "AudioReader.hpp"
+#include "BufferStore.hpp"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace libste {
+
+namespace {
+
+uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint64_t le64(const uint8_t* p) { return le32(p) | (uint64_t(le32(p + 4)) << 32); }
+uint32_t be32(const uint8_t* p) { return (uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+
+// 80-bit IEEE extended (AIFF sample rate)
+double extended_to_double(const uint8_t* p) {
+    int exponent = ((p[0] & 0x7F) << 8) | p[1];
+    uint64_t mantissa = (uint64_t(be32(p + 2)) << 32) | be32(p + 6);
+    if (exponent == 0 && mantissa == 0) return 0.0;
+    double value = std::ldexp(double(mantissa), exponent - 16383 - 63);
+    return (p[0] & 0x80) ? -value : value;
+}
+
+bool read_exact(std::istream& in, uint8_t* dst, size_t n) {
+    return static_cast<size_t>(in.rdbuf()->sgetn(reinterpret_cast<char*>(dst), n)) == n;
+}
+
+bool skip(std::istream& in, uint64_t n) {
+    uint8_t scratch[4096];
+    while (n > 0) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(n, sizeof(scratch)));
+        if (!read_exact(in, scratch, chunk)) return false;
+        n -= chunk;
+    }
+    return true;
+}
+
+constexpr uint64_t kUnknownSize = UINT64_MAX;
+
+// Far beyond any real layout; bounds the per-block buffers a header can ask for
+constexpr uint16_t kMaxChannels = 64;
+// Anything outside this is a corrupt header, not audio
+constexpr uint32_t kMinSampleRate = 1000;
+constexpr uint32_t kMaxSampleRate = 384000;
+
+} // namespace
+
+bool AudioReader::is_audio_file(const std::string& path) {
+    auto in = open_input_stream(path);
+    char magic[4] = {};
+    if (!in || !in->read(magic, 4)) return false;
+    return std::memcmp(magic, "RIFF", 4) == 0 || std::memcmp(magic, "RF64", 4) == 0 ||
+           std::memcmp(magic, "FORM", 4) == 0;
+}
+
+bool AudioReader::open(const std::string& path) {
+    if (path == "-") return open(std::cin);
+    file_ = open_input_stream(path);
+    if (!file_) return false;
+    return open(*file_);
+}
+
+bool AudioReader::open(std::istream& in) {
+    in_ = &in;
+    format_ = AudioFormat{};
+    uint8_t header[12];
+    if (!read_exact(in, header, 12)) return false;
+
+    if ((std::memcmp(header, "RIFF", 4) == 0 || std::memcmp(header, "RF64", 4) == 0) &&
+        std::memcmp(header + 8, "WAVE", 4) == 0) {
+        return parse_wav();
+    }
+    if (std::memcmp(header, "FORM", 4) == 0) {
+        if (std::memcmp(header + 8, "AIFF", 4) == 0) return parse_aiff(false);
+        if (std::memcmp(header + 8, "AIFC", 4) == 0) return parse_aiff(true);
+    }
+    return false;
+}
+
+bool AudioReader::parse_wav() {
+    format_.container = AudioContainer::Wav;
+    bool have_fmt = false;
+    uint64_t ds64_data_size = kUnknownSize;
+    uint8_t chunk[8];
+
+    while (read_exact(*in_, chunk, 8)) {
+        uint32_t size = le32(chunk + 4);
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (size < 16 || size > 256) return false;
+            uint8_t fmt[256];
+            if (!read_exact(*in_, fmt, size)) return false;
+            uint16_t tag = le16(fmt);
+            // WAVE_FORMAT_EXTENSIBLE carries the real tag in the sub-format GUID
+            if (tag == 0xFFFE && size >= 26) tag = le16(fmt + 24);
+            if (tag != 1) return false;
+            format_.channels = le16(fmt + 2);
+            format_.sample_rate = le32(fmt + 4);
+            format_.bits_per_sample = le16(fmt + 14);
+            have_fmt = true;
+            if (size & 1) skip(*in_, 1);
+        } else if (std::memcmp(chunk, "ds64", 4) == 0) {
+            // RF64: real 64-bit sizes live here
+            if (size < 24) return false;
+            std::vector<uint8_t> ds64(size);
+            if (!read_exact(*in_, ds64.data(), size)) return false;
+            ds64_data_size = le64(&ds64[8]);
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!have_fmt) return false;
+            if (size == 0xFFFFFFFF) data_remaining_ = ds64_data_size;  // RF64 or unknown (pipe)
+            else data_remaining_ = size;
+            break;
+        } else {
+            if (!skip(*in_, size + (size & 1))) return false;
+        }
+    }
+
+    if (!have_fmt || format_.channels == 0 || format_.channels > kMaxChannels) return false;
+    if (format_.sample_rate < kMinSampleRate || format_.sample_rate > kMaxSampleRate) return false;
+    if (format_.bits_per_sample != 8 && format_.bits_per_sample != 16 && format_.bits_per_sample != 24) return false;
+    if (data_remaining_ != kUnknownSize) {
+        format_.frames = data_remaining_ / (format_.channels * (format_.bits_per_sample / 8));
+    }
+    return true;
+}
+
+bool AudioReader::parse_aiff(bool aifc) {
+    format_.container = AudioContainer::Aiff;
+    format_.big_endian = true;
+    bool have_comm = false;
+    uint8_t chunk[8];
+
+    while (read_exact(*in_, chunk, 8)) {
+        uint32_t size = be32(chunk + 4);
+        if (std::memcmp(chunk, "COMM", 4) == 0) {
+            if (size < 18 || size > 256) return false;
+            uint8_t comm[256];
+            if (!read_exact(*in_, comm, size + (size & 1))) return false;
+            format_.channels = be16(comm);
+            format_.frames = be32(comm + 2);
+            format_.bits_per_sample = be16(comm + 6);
+            double rate = extended_to_double(comm + 8);
+            if (!(rate >= kMinSampleRate && rate <= kMaxSampleRate)) return false;
+            format_.sample_rate = static_cast<uint32_t>(std::lround(rate));
+            if (aifc && size >= 22) {
+                if (std::memcmp(comm + 18, "sowt", 4) == 0) format_.big_endian = false;
+                else if (std::memcmp(comm + 18, "NONE", 4) != 0) return false;  // Compressed
+            }
+            have_comm = true;
+        } else if (std::memcmp(chunk, "SSND", 4) == 0) {
+            if (!have_comm || size < 8) return false;
+            uint8_t ssnd[8];
+            if (!read_exact(*in_, ssnd, 8)) return false;
+            uint32_t offset = be32(ssnd);
+            if (offset > size - 8 || !skip(*in_, offset)) return false;
+            data_remaining_ = size - 8 - offset;
+            break;
+        } else {
+            if (!skip(*in_, size + (size & 1))) return false;
+        }
+    }
+
+    if (!have_comm || format_.channels == 0 || format_.channels > kMaxChannels) return false;
+    return format_.bits_per_sample == 8 || format_.bits_per_sample == 16 || format_.bits_per_sample == 24;
+}
+
+size_t AudioReader::read(std::span<float> out) {
+    if (!in_ || format_.channels == 0) return 0;
+    const size_t bytes_per_sample = format_.bits_per_sample / 8;
+    const size_t frame_bytes = bytes_per_sample * format_.channels;
+    size_t frames = out.size() / format_.channels;
+    if (data_remaining_ != kUnknownSize) frames = std::min<uint64_t>(frames, data_remaining_ / frame_bytes);
+    if (frames == 0) return 0;
+
+    raw_.resize(frames * frame_bytes);
+    size_t got = static_cast<size_t>(in_->rdbuf()->sgetn(reinterpret_cast<char*>(raw_.data()), raw_.size()));
+    frames = got / frame_bytes;
+    if (data_remaining_ != kUnknownSize) data_remaining_ -= got;
+
+    const size_t samples = frames * format_.channels;
+    const uint8_t* p = raw_.data();
+    const bool wav = format_.container == AudioContainer::Wav;
+    switch (format_.bits_per_sample) {
+        case 8:
+            // WAV 8-bit is unsigned, AIFF 8-bit is signed
+            for (size_t i = 0; i < samples; ++i) {
+                int v = wav ? int(p[i]) - 128 : int(int8_t(p[i]));
+                out[i] = v * (1.0f / 128.0f);
+            }
+            break;
+        case 16:
+            for (size_t i = 0; i < samples; ++i, p += 2) {
+                int16_t v = static_cast<int16_t>(format_.big_endian ? be16(p) : le16(p));
+                out[i] = v * (1.0f / 32768.0f);
+            }
+            break;
+        case 24:
+            for (size_t i = 0; i < samples; ++i, p += 3) {
+                uint32_t u = format_.big_endian ? (uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8)
+                                                : (uint32_t(p[2]) << 24) | (p[1] << 16) | (p[0] << 8);
+                int32_t v = static_cast<int32_t>(u);
+                out[i] = (v >> 8) * (1.0f / 8388608.0f);
+            }
+            break;
+    }
+    return frames;
+}
+
+size_t AudioReader::read_mono(std::span<float> out) {
+    const int channels = format_.channels;
+    if (channels == 1) return read(out);
+
+    mix_.resize(out.size() * channels);
+    size_t frames = read(mix_);
+    const float scale = 1.0f / channels;
+    for (size_t f = 0; f < frames; ++f) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c) sum += mix_[f * channels + c];
+        out[f] = sum * scale;
+    }
+    return frames;
+}
+
+} // namespace libste
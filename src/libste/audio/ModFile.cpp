@@ -0,0 +1,94 @@
+#include "ModFile.hpp"
+#include "BufferStore.hpp"
+#include <istream>
+#include <cstring>
+#include <algorithm>
+
+namespace libste {
+
+namespace {
+
+constexpr size_t kTagOffset = 1080;
+constexpr size_t kPatternOffset = 1084;
+
+uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+
+int channels_from_tag(const uint8_t* tag) {
+    std::string t(reinterpret_cast<const char*>(tag), 4);
+    if (t == "M.K." || t == "M!K!" || t == "FLT4" || t == "4CHN") return 4;
+    if (t == "FLT8" || t == "OCTA" || t == "CD81") return 8;
+    if (t[0] >= '1' && t[0] <= '9' && t.substr(1) == "CHN") return t[0] - '0';
+    if (t[0] >= '1' && t[0] <= '3' && t[1] >= '0' && t[1] <= '9' && t.substr(2) == "CH") {
+        return (t[0] - '0') * 10 + (t[1] - '0');
+    }
+    return 0;
+}
+
+} // namespace
+
+bool load_mod(std::span<const uint8_t> data, ModSong& song) {
+    song = ModSong{};
+    if (data.size() < kPatternOffset) return false;
+    song.channels = channels_from_tag(&data[kTagOffset]);
+    if (song.channels == 0) return false;
+
+    const char* title = reinterpret_cast<const char*>(data.data());
+    song.title.assign(title, strnlen(title, 20));
+
+    for (int s = 0; s < 31; ++s) {
+        const uint8_t* h = &data[20 + s * 30];
+        ModSample& sample = song.samples[s];
+        sample.name.assign(reinterpret_cast<const char*>(h), strnlen(reinterpret_cast<const char*>(h), 22));
+        sample.data.resize(size_t(be16(h + 22)) * 2);
+        sample.finetune = static_cast<int8_t>((h[24] & 0x0F) << 4) >> 4;
+        sample.volume = std::min<uint8_t>(h[25], 64);
+        sample.loop_start = uint32_t(be16(h + 26)) * 2;
+        sample.loop_length = uint32_t(be16(h + 28)) * 2;
+    }
+
+    uint8_t length = data[950];
+    if (length == 0 || length > 128) return false;
+    song.orders.assign(&data[952], &data[952] + length);
+    // Patterns stored = highest entry in the full order table, used or not
+    int patterns = *std::max_element(&data[952], &data[952 + 128]) + 1;
+
+    size_t pattern_bytes = size_t(patterns) * 64 * song.channels * 4;
+    if (kPatternOffset + pattern_bytes > data.size()) return false;
+    song.cells.resize(size_t(patterns) * 64 * song.channels);
+    const uint8_t* p = &data[kPatternOffset];
+    for (auto& c : song.cells) {
+        c.sample = (p[0] & 0xF0) | (p[2] >> 4);
+        c.period = static_cast<uint16_t>(((p[0] & 0x0F) << 8) | p[1]);
+        c.effect = p[2] & 0x0F;
+        c.param = p[3];
+        p += 4;
+    }
+
+    // Sample bodies follow; truncated modules keep what is present
+    size_t pos = kPatternOffset + pattern_bytes;
+    for (auto& sample : song.samples) {
+        size_t n = std::min(sample.data.size(), data.size() - pos);
+        if (n) std::memcpy(sample.data.data(), data.data() + pos, n);
+        sample.data.resize(n);
+        pos += n;
+        uint32_t size = static_cast<uint32_t>(n);
+        if (sample.loop_start >= size) sample.loop_length = 0;
+        else sample.loop_length = std::min(sample.loop_length, size - sample.loop_start);
+    }
+    return true;
+}
+
+bool load_mod_file(const std::string& path, ModSong& song) {
+    std::vector<uint8_t> storage;
+    std::span<const uint8_t> data;
+    return load_input(path, storage, data) && load_mod(data, song);
+}
+
+bool is_mod_file(const std::string& path) {
+    auto in = open_input_stream(path);
+    uint8_t tag[4];
+    if (!in || !in->seekg(kTagOffset) || !in->read(reinterpret_cast<char*>(tag), 4)) return false;
+    return channels_from_tag(tag) != 0;
+}
+
+} // namespace libste
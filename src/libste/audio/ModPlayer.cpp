@@ -0,0 +1,326 @@
+#include "ModPlayer.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace libste {
+
+namespace {
+
+constexpr uint64_t kPaulaClock = 3546895;  // PAL
+
+// ProTracker periods, finetune 0, octaves 1-3
+constexpr int kPeriods[36] = {
+    856, 808, 762, 720, 678, 640, 604, 570, 538, 508, 480, 453,
+    428, 404, 381, 360, 339, 320, 302, 285, 269, 254, 240, 226,
+    214, 202, 190, 180, 170, 160, 151, 143, 135, 127, 120, 113,
+};
+
+constexpr uint8_t kSine[32] = {
+    0,   24,  49,  74,  97,  120, 141, 161, 180, 197, 212, 224, 235, 244, 250, 253,
+    255, 253, 250, 244, 235, 224, 212, 197, 180, 161, 141, 120, 97,  74,  49,  24,
+};
+
+int tuned_period(int note, int finetune) {
+    return static_cast<int>(std::lround(kPeriods[note] * std::pow(2.0, -finetune / 96.0)));
+}
+
+int nearest_note(int period) {
+    int best = 0;
+    for (int n = 1; n < 36; ++n) {
+        if (std::abs(kPeriods[n] - period) < std::abs(kPeriods[best] - period)) best = n;
+    }
+    return best;
+}
+
+int waveform(int wave, int pos) {
+    pos &= 63;
+    switch (wave & 3) {
+        case 1: return 255 - pos * 8;                  // Ramp down
+        case 2: return pos < 32 ? 255 : -255;           // Square
+        default: return pos < 32 ? kSine[pos] : -kSine[pos & 31];
+    }
+}
+
+// acc[i] += samples[i] * volume. Samples are 8-bit and volume <= 64, so the
+// product fits in 16 bits and SSE2 can multiply eight at a time.
+void accumulate(int32_t* acc, const int16_t* samples, int volume, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i vol = _mm_set1_epi16(static_cast<short>(volume));
+    for (; i + 8 <= n; i += 8) {
+        __m128i s = _mm_mullo_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i)), vol);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+        _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), lo));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), hi));
+    }
+#endif
+    for (; i < n; ++i) acc[i] += samples[i] * volume;
+}
+
+} // namespace
+
+ModPlayer::ModPlayer(const ModSong& song, uint32_t sample_rate)
+    : song_(song), rate_(sample_rate), channels_(song.channels), visited_(song.orders.size(), 0) {
+    process_row();
+}
+
+void ModPlayer::trigger(Channel& ch, const ModCell& c) {
+    if (c.sample > 0 && c.sample <= 31) {
+        ch.sample = &song_.samples[c.sample - 1];
+        ch.volume = ch.sample->volume;
+        ch.finetune = ch.sample->finetune;
+    }
+    if (c.period == 0) return;
+
+    int period = tuned_period(nearest_note(c.period), ch.finetune);
+    if (c.effect == 0x3 || c.effect == 0x5) {
+        ch.target_period = period;  // Tone portamento slides instead of retriggering
+        return;
+    }
+    if (c.effect == 0xE && (c.param >> 4) == 0xD && (c.param & 0x0F) != 0) {
+        ch.note_period = period;    // Note delay: triggered later by effect_tick
+        return;
+    }
+    ch.period = ch.target_period = period;
+    ch.pos = 0;
+    ch.active = ch.sample && !ch.sample->data.empty();
+    if (!(ch.vibrato_wave & 4)) ch.vibrato_pos = 0;
+    if (!(ch.tremolo_wave & 4)) ch.tremolo_pos = 0;
+}
+
+void ModPlayer::effect_tick0(Channel& ch) {
+    const ModCell& c = ch.cell;
+    int x = c.param >> 4, y = c.param & 0x0F;
+    switch (c.effect) {
+        case 0x3: if (c.param) ch.porta_speed = c.param; break;
+        case 0x4:
+            if (x) ch.vibrato_speed = x;
+            if (y) ch.vibrato_depth = y;
+            break;
+        case 0x7:
+            if (x) ch.tremolo_speed = x;
+            if (y) ch.tremolo_depth = y;
+            break;
+        case 0x9:
+            if (c.param) ch.offset = c.param << 8;
+            if (c.period) {
+                ch.pos = uint64_t(ch.offset) << 16;
+                if (ch.sample && ch.offset >= static_cast<int>(ch.sample->data.size())) ch.active = false;
+            }
+            break;
+        case 0xB:
+            next_order_ = c.param;
+            next_row_ = next_row_ < 0 ? 0 : next_row_;
+            break;
+        case 0xC: ch.volume = std::min<int>(c.param, 64); break;
+        case 0xD:
+            if (next_order_ < 0) next_order_ = order_ + 1;
+            next_row_ = std::min(x * 10 + y, 63);
+            break;
+        case 0xE:
+            switch (x) {
+                case 0x1: ch.period = std::max(ch.period - y, 113); break;
+                case 0x2: ch.period = std::min(ch.period + y, 856); break;
+                case 0x4: ch.vibrato_wave = y; break;
+                case 0x5: ch.finetune = static_cast<int8_t>(y << 4) >> 4; break;
+                case 0x6:
+                    if (y == 0) {
+                        ch.loop_row = row_;
+                    } else if (ch.loop_count == 0) {
+                        ch.loop_count = y;
+                        next_row_ = ch.loop_row;
+                        next_order_ = order_;
+                        loop_jump_ = true;
+                    } else if (--ch.loop_count > 0) {
+                        next_row_ = ch.loop_row;
+                        next_order_ = order_;
+                        loop_jump_ = true;
+                    }
+                    break;
+                case 0x7: ch.tremolo_wave = y; break;
+                case 0xA: ch.volume = std::min(ch.volume + y, 64); break;
+                case 0xB: ch.volume = std::max(ch.volume - y, 0); break;
+                case 0xC: if (y == 0) ch.volume = 0; break;
+                case 0xE: pattern_delay_ = y; break;
+            }
+            break;
+        case 0xF:
+            if (c.param == 0) ended_ = true;
+            else if (c.param < 32) speed_ = c.param;
+            else tempo_ = c.param;
+            break;
+    }
+}
+
+void ModPlayer::effect_tick(Channel& ch) {
+    const ModCell& c = ch.cell;
+    int x = c.param >> 4, y = c.param & 0x0F;
+    auto volume_slide = [&] { ch.volume = std::clamp(ch.volume + (x ? x : -y), 0, 64); };
+    auto tone_porta = [&] {
+        if (ch.period < ch.target_period) ch.period = std::min(ch.period + ch.porta_speed, ch.target_period);
+        else if (ch.period > ch.target_period) ch.period = std::max(ch.period - ch.porta_speed, ch.target_period);
+    };
+
+    switch (c.effect) {
+        case 0x1: ch.period = std::max(ch.period - c.param, 113); break;
+        case 0x2: ch.period = std::min(ch.period + c.param, 856); break;
+        case 0x3: tone_porta(); break;
+        case 0x4: ch.vibrato_pos += ch.vibrato_speed; break;
+        case 0x5: tone_porta(); volume_slide(); break;
+        case 0x6: ch.vibrato_pos += ch.vibrato_speed; volume_slide(); break;
+        case 0x7: ch.tremolo_pos += ch.tremolo_speed; break;
+        case 0xA: volume_slide(); break;
+        case 0xE:
+            if (x == 0x9 && y && tick_ % y == 0) {
+                ch.pos = 0;
+                ch.active = ch.sample && !ch.sample->data.empty();
+            }
+            if (x == 0xC && tick_ == y) ch.volume = 0;
+            if (x == 0xD && tick_ == y && ch.note_period) {
+                ch.period = ch.target_period = ch.note_period;
+                ch.note_period = 0;
+                ch.pos = 0;
+                ch.active = ch.sample && !ch.sample->data.empty();
+            }
+            break;
+    }
+}
+
+void ModPlayer::process_row() {
+    if (order_ >= static_cast<int>(song_.orders.size())) {
+        ended_ = true;
+        return;
+    }
+    // A row seen before (outside an E6x loop) means the song has wrapped
+    uint64_t bit = uint64_t(1) << row_;
+    if ((visited_[order_] & bit) && !loop_jump_) {
+        ended_ = true;
+        return;
+    }
+    visited_[order_] |= bit;
+    loop_jump_ = false;
+
+    int pattern = song_.orders[order_];
+    for (int i = 0; i < song_.channels; ++i) {
+        Channel& ch = channels_[i];
+        ch.cell = song_.cell(pattern, row_, i);
+        trigger(ch, ch.cell);
+        effect_tick0(ch);
+    }
+}
+
+void ModPlayer::advance_row() {
+    if (pattern_delay_ > 0) {
+        --pattern_delay_;
+        return;
+    }
+    if (next_order_ >= 0) {
+        if (loop_jump_) {
+            // Rows between the loop start and here get replayed
+            visited_[order_] &= (uint64_t(1) << next_row_) - 1;
+        }
+        order_ = next_order_;
+        row_ = next_row_ < 0 ? 0 : next_row_;
+    } else if (++row_ >= 64) {
+        row_ = 0;
+        ++order_;
+    }
+    next_order_ = next_row_ = -1;
+    process_row();
+}
+
+void ModPlayer::mix(Channel& ch, int index, size_t frames) {
+    if (!ch.active || !ch.sample || ch.out_period <= 0) return;
+    const ModSample& s = *ch.sample;
+    const bool looped = s.loop_length > 2;
+    const uint64_t end = uint64_t(looped ? s.loop_start + s.loop_length : s.data.size()) << 16;
+    const uint64_t loop_start = uint64_t(s.loop_start) << 16;
+    const uint64_t loop_length = uint64_t(s.loop_length) << 16;
+    const int8_t* data = s.data.data();
+    const uint64_t step = ch.step;
+
+    // Fetch: resample into 16-bit scratch in runs that stop at the loop end
+    size_t done = 0;
+    uint64_t pos = ch.pos;
+    while (done < frames) {
+        if (pos >= end) {
+            if (!looped) {
+                ch.active = false;
+                break;
+            }
+            pos = loop_start + (pos - end) % loop_length;
+        }
+        size_t run = std::min<uint64_t>((end - pos + step - 1) / step, frames - done);
+        int16_t* out = scratch_.data() + done;
+        for (size_t i = 0; i < run; ++i) {
+            out[i] = data[pos >> 16];
+            pos += step;
+        }
+        done += run;
+    }
+    ch.pos = pos;
+
+    // Accumulate into the side this channel is panned to
+    int32_t* acc = ((index & 3) == 0 || (index & 3) == 3) ? mix_l_.data() : mix_r_.data();
+    if (ch.out_volume > 0) accumulate(acc, scratch_.data(), ch.out_volume, done);
+}
+
+bool ModPlayer::render_tick(std::vector<float>& left, std::vector<float>& right) {
+    if (ended_) return false;
+
+    if (tick_ > 0) {
+        for (auto& ch : channels_) effect_tick(ch);
+    }
+    for (auto& ch : channels_) {
+        ch.out_period = ch.period;
+        ch.out_volume = ch.volume;
+        if (ch.cell.effect == 0x0 && ch.cell.param && tick_ > 0) {
+            // Arpeggio cycles base note, +x, +y semitones
+            int offsets[3] = { 0, ch.cell.param >> 4, ch.cell.param & 0x0F };
+            int note = std::min(nearest_note(ch.period) + offsets[tick_ % 3], 35);
+            ch.out_period = tuned_period(note, ch.finetune);
+        }
+        if (ch.cell.effect == 0x4 || ch.cell.effect == 0x6) {
+            ch.out_period += waveform(ch.vibrato_wave, ch.vibrato_pos) * ch.vibrato_depth / 128;
+        }
+        if (ch.cell.effect == 0x7) {
+            ch.out_volume = std::clamp(ch.volume + waveform(ch.tremolo_wave, ch.tremolo_pos) * ch.tremolo_depth / 64, 0, 64);
+        }
+        if (ch.out_period > 0) ch.step = static_cast<uint32_t>((kPaulaClock << 16) / (uint64_t(ch.out_period) * rate_));
+    }
+
+    // 2.5 ms per BPM unit: rate * 5 / (2 * BPM) frames, remainder carried
+    uint32_t divisor = 2 * tempo_;
+    tick_remainder_ += rate_ * 5;
+    size_t frames = tick_remainder_ / divisor;
+    tick_remainder_ %= divisor;
+
+    mix_l_.assign(frames, 0);
+    mix_r_.assign(frames, 0);
+    scratch_.resize(frames);
+    for (int i = 0; i < song_.channels; ++i) mix(channels_[i], i, frames);
+
+    // Full scale is every channel on a side at maximum
+    const float scale = 1.0f / (128.0f * 64.0f * std::max(1, song_.channels / 2));
+    size_t base = left.size();
+    left.resize(base + frames);
+    right.resize(base + frames);
+    for (size_t i = 0; i < frames; ++i) {
+        left[base + i] = mix_l_[i] * scale;
+        right[base + i] = mix_r_[i] * scale;
+    }
+
+    if (++tick_ >= speed_) {
+        tick_ = 0;
+        advance_row();
+    }
+    return true;
+}
+
+} // namespace libste
@@ -0,0 +1,152 @@
+#include "Pcm.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace libste {
+
+void flip_pcm_sign(std::span<uint8_t> samples) {
+    uint8_t* p = samples.data();
+    size_t n = samples.size();
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    // 64 bytes per iteration, two 32-byte lanes
+    const __m256i bias = _mm256_set1_epi8(static_cast<char>(0x80));
+    for (; i + 64 <= n; i += 64) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i), _mm256_xor_si256(a, bias));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i + 32), _mm256_xor_si256(b, bias));
+    }
+#elif defined(__SSE2__)
+    // 64 bytes per iteration, four 16-byte lanes
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+    for (; i + 64 <= n; i += 64) {
+        for (size_t j = 0; j < 64; j += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + j));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i + j), _mm_xor_si128(v, bias));
+        }
+    }
+#endif
+
+    // Portable path (and the tail): eight bytes per 64-bit XOR
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v;
+        std::memcpy(&v, p + i, 8);
+        v ^= 0x8080808080808080ULL;
+        std::memcpy(p + i, &v, 8);
+    }
+    for (; i < n; ++i) p[i] ^= 0x80;
+}
+
+template <>
+void interleave_stereo<uint8_t>(std::span<const uint8_t> left, std::span<const uint8_t> right, std::span<uint8_t> out) {
+    size_t n = std::min({ left.size(), right.size(), out.size() / 2 });
+    const uint8_t* l = left.data();
+    const uint8_t* r = right.data();
+    uint8_t* o = out.data();
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    // 32 frames per iteration; unpack works within 128-bit lanes, so the
+    // halves are put back in order afterwards
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r + i));
+        __m256i lo = _mm256_unpacklo_epi8(a, b);
+        __m256i hi = _mm256_unpackhi_epi8(a, b);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + 2 * i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+#elif defined(__SSE2__)
+    // 16 frames per iteration
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 2 * i), _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 2 * i + 16), _mm_unpackhi_epi8(a, b));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        o[2 * i] = l[i];
+        o[2 * i + 1] = r[i];
+    }
+}
+
+template <>
+void deinterleave_stereo<uint8_t>(std::span<const uint8_t> in, std::span<uint8_t> left, std::span<uint8_t> right) {
+    size_t n = std::min({ in.size() / 2, left.size(), right.size() });
+    const uint8_t* s = in.data();
+    uint8_t* l = left.data();
+    uint8_t* r = right.data();
+    size_t i = 0;
+
+    // Each L/R pair is a 16-bit word: L is its low byte, R its high byte.
+    // Masking or shifting isolates one of them, and an unsigned saturating
+    // pack narrows the words back to bytes.
+#if defined(__AVX2__)
+    // 32 frames per iteration; pack works within 128-bit lanes, so the
+    // quarters are put back in order afterwards
+    const __m256i low = _mm256_set1_epi16(0x00FF);
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 2 * i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 2 * i + 32));
+        __m256i even = _mm256_packus_epi16(_mm256_and_si256(a, low), _mm256_and_si256(b, low));
+        __m256i odd = _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(l + i), _mm256_permute4x64_epi64(even, 0xD8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), _mm256_permute4x64_epi64(odd, 0xD8));
+    }
+#elif defined(__SSE2__)
+    // 16 frames per iteration
+    const __m128i low = _mm_set1_epi16(0x00FF);
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 2 * i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 2 * i + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(l + i), _mm_packus_epi16(_mm_and_si128(a, low), _mm_and_si128(b, low)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        l[i] = s[2 * i];
+        r[i] = s[2 * i + 1];
+    }
+}
+
+bool flip_pcm_sign_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+
+    ::madvise(map, size, MADV_SEQUENTIAL);
+    flip_pcm_sign(std::span<uint8_t>(static_cast<uint8_t*>(map), size));
+    bool ok = ::msync(map, size, MS_SYNC) == 0;
+    ::munmap(map, size);
+    return ok;
+}
+
+} // namespace libste
@@ -0,0 +1,133 @@
+#include "Resampler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace libste {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kPassband = 0.92;   // Fraction of the lower Nyquist frequency kept
+constexpr double kKaiserBeta = 8.0;  // ~80 dB stopband
+
+double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+// Inner FIR loop: eight independent accumulators so the compiler can keep
+// the multiply-adds in SIMD registers (taps are always a multiple of 8).
+inline float dot(const float* a, const float* b, int n) {
+    float acc[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < n; i += 8) {
+        for (int j = 0; j < 8; ++j) acc[j] += a[i + j] * b[i + j];
+    }
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+} // namespace
+
+bool Resampler::supports(uint32_t in_rate, uint32_t out_rate) {
+    if (in_rate == 0 || out_rate == 0) return false;
+    return in_rate / out_rate < MAX_RATIO && out_rate / in_rate < MAX_RATIO;
+}
+
+Resampler::Resampler(uint32_t in_rate, uint32_t out_rate, int zero_crossings)
+    : in_rate_(in_rate), out_rate_(out_rate) {
+    // A zero step would never advance the output position
+    if (!supports(in_rate, out_rate)) return;
+    double cutoff = std::min(1.0, double(out_rate) / in_rate) * kPassband;
+    int half = static_cast<int>(std::ceil(zero_crossings / cutoff));
+    taps_ = (2 * half + 7) & ~7;
+    const int center = taps_ / 2;
+
+    bank_.resize(size_t(PHASES + 1) * taps_);
+    const double i0_beta = bessel_i0(kKaiserBeta);
+    for (int p = 0; p <= PHASES; ++p) {
+        float* row = &bank_[size_t(p) * taps_];
+        double sum = 0.0;
+        for (int k = 0; k < taps_; ++k) {
+            double t = (k - center + 1) - double(p) / PHASES;
+            double x = t / center;
+            double w = (std::abs(x) < 1.0) ? bessel_i0(kKaiserBeta * std::sqrt(1.0 - x * x)) / i0_beta : 0.0;
+            double arg = kPi * cutoff * t;
+            double sinc = (t == 0.0) ? 1.0 : std::sin(arg) / arg;
+            row[k] = static_cast<float>(cutoff * sinc * w);
+            sum += row[k];
+        }
+        // Unity DC gain on every phase
+        for (int k = 0; k < taps_; ++k) row[k] = static_cast<float>(row[k] / sum);
+    }
+
+    step_ = (uint64_t(in_rate) << 32) / out_rate;
+    hist_.assign(center - 1, 0.0f);
+}
+
+void Resampler::run(std::vector<float>& out, uint64_t limit) {
+    const int center = taps_ / 2;
+    while (produced_ < limit) {
+        uint64_t n = pos_ >> 32;
+        if (n + center >= fed_) break;
+
+        const float* x = &hist_[n - consumed_];
+        uint32_t frac = static_cast<uint32_t>(pos_);
+        uint32_t phase = frac >> 24;                      // Top 8 bits select the filter
+        float t = float(frac & 0x00FFFFFF) / float(1 << 24); // The rest interpolates to the next one
+        float y0 = dot(&bank_[size_t(phase) * taps_], x, taps_);
+        float y1 = dot(&bank_[size_t(phase + 1) * taps_], x, taps_);
+        out.push_back(y0 + t * (y1 - y0));
+
+        pos_ += step_;
+        ++produced_;
+    }
+
+    // Drop input that no future output can reach
+    uint64_t keep_from = std::min<uint64_t>(pos_ >> 32, fed_);
+    if (keep_from > consumed_ + 4096) {
+        size_t drop = static_cast<size_t>(keep_from - consumed_);
+        hist_.erase(hist_.begin(), hist_.begin() + drop);
+        consumed_ += drop;
+    }
+}
+
+void Resampler::process(std::span<const float> in, std::vector<float>& out) {
+    if (!ok()) return;
+    hist_.insert(hist_.end(), in.begin(), in.end());
+    fed_ += in.size();
+    out.reserve(out.size() + size_t(double(in.size()) * out_rate_ / in_rate_) + 2);
+    run(out, UINT64_MAX);
+}
+
+void Resampler::flush(std::vector<float>& out) {
+    if (!ok()) return;
+    // Pad with silence past the last real sample, then stop at the exact output length
+    uint64_t total = (fed_ * out_rate_ + in_rate_ - 1) / in_rate_;
+    size_t pad = taps_;
+    hist_.insert(hist_.end(), pad, 0.0f);
+    fed_ += pad;
+    run(out, total);
+}
+
+void quantize_to_s8(std::span<const float> in, std::span<uint8_t> out, bool dither, uint32_t& seed) {
+    size_t n = std::min(in.size(), out.size());
+    for (size_t i = 0; i < n; ++i) {
+        float v = in[i] * 128.0f;
+        if (dither) {
+            // TPDF: sum of two uniform variables, +/- 1 LSB peak
+            seed = seed * 1664525u + 1013904223u;
+            float r1 = float(seed >> 8) * (1.0f / 16777216.0f);
+            seed = seed * 1664525u + 1013904223u;
+            float r2 = float(seed >> 8) * (1.0f / 16777216.0f);
+            v += r1 - r2;
+        }
+        int s = static_cast<int>(std::lround(v));
+        out[i] = static_cast<uint8_t>(static_cast<int8_t>(std::clamp(s, -128, 127)));
+    }
+}
+
+} // namespace libste
@@ -0,0 +1,118 @@
+#include "WavWriter.hpp"
+#include "BufferStore.hpp"
+#include <iostream>
+#include <cstring>
+
+namespace libste {
+
+namespace {
+
+void put_tag(std::vector<uint8_t>& h, const char* tag) { h.insert(h.end(), tag, tag + 4); }
+void put_le16(std::vector<uint8_t>& h, uint16_t v) { h.push_back(v & 0xFF); h.push_back(v >> 8); }
+void put_le32(std::vector<uint8_t>& h, uint32_t v) { put_le16(h, v & 0xFFFF); put_le16(h, v >> 16); }
+void put_le64(std::vector<uint8_t>& h, uint64_t v) { put_le32(h, v & 0xFFFFFFFF); put_le32(h, v >> 32); }
+
+constexpr uint32_t kDs64Size = 28;            // riff size, data size, sample count, table length
+constexpr uint64_t kHeaderSize = 12 + 8 + kDs64Size + 8 + 16 + 8;
+constexpr uint64_t kRiffLimit = 0xFFFFFFFFULL;
+
+} // namespace
+
+WavWriter::~WavWriter() {
+    if (out_) close();
+}
+
+std::vector<uint8_t> WavWriter::build_header(bool rf64) const {
+    uint64_t riff_size = kHeaderSize - 8 + data_bytes_ + (data_bytes_ & 1);
+    uint32_t frame_bytes = channels_ * (bits_ / 8);
+
+    std::vector<uint8_t> h;
+    h.reserve(kHeaderSize);
+    put_tag(h, rf64 ? "RF64" : "RIFF");
+    put_le32(h, (rf64 || !seekable_) ? 0xFFFFFFFF : static_cast<uint32_t>(riff_size));
+    put_tag(h, "WAVE");
+
+    // Reserved space: JUNK for plain RIFF, ds64 once promoted to RF64
+    put_tag(h, rf64 ? "ds64" : "JUNK");
+    put_le32(h, kDs64Size);
+    put_le64(h, rf64 ? riff_size : 0);
+    put_le64(h, rf64 ? data_bytes_ : 0);
+    put_le64(h, rf64 ? data_bytes_ / frame_bytes : 0);
+    put_le32(h, 0);
+
+    put_tag(h, "fmt ");
+    put_le32(h, 16);
+    put_le16(h, 1);  // PCM
+    put_le16(h, channels_);
+    put_le32(h, sample_rate_);
+    put_le32(h, sample_rate_ * frame_bytes);
+    put_le16(h, static_cast<uint16_t>(frame_bytes));
+    put_le16(h, bits_);
+
+    put_tag(h, "data");
+    put_le32(h, (rf64 || !seekable_) ? 0xFFFFFFFF : static_cast<uint32_t>(data_bytes_));
+    return h;
+}
+
+bool WavWriter::open(const std::string& path, uint32_t sample_rate, uint16_t channels, uint16_t bits_per_sample) {
+    if (channels == 0 || (bits_per_sample != 8 && bits_per_sample != 16)) return false;
+    sample_rate_ = sample_rate;
+    channels_ = channels;
+    bits_ = bits_per_sample;
+    data_bytes_ = 0;
+
+    if (path == "-") {
+        out_ = &std::cout;
+        seekable_ = false;
+    } else {
+        file_ = open_output_stream(path);
+        if (!file_) return false;
+        out_ = file_.get();
+        seekable_ = true;
+    }
+
+    auto header = build_header(false);
+    out_->write(reinterpret_cast<const char*>(header.data()), header.size());
+    return out_->good();
+}
+
+bool WavWriter::write(std::span<const uint8_t> pcm) {
+    if (!out_) return false;
+    out_->write(reinterpret_cast<const char*>(pcm.data()), pcm.size());
+    data_bytes_ += pcm.size();
+    return out_->good();
+}
+
+bool WavWriter::write(std::span<const int16_t> samples) {
+    scratch_.resize(samples.size() * 2);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        uint16_t v = static_cast<uint16_t>(samples[i]);
+        scratch_[2 * i] = v & 0xFF;
+        scratch_[2 * i + 1] = v >> 8;
+    }
+    return write(std::span<const uint8_t>(scratch_));
+}
+
+bool WavWriter::close() {
+    if (!out_) return false;
+    // RIFF chunks are word aligned
+    if (data_bytes_ & 1) out_->put(0);
+
+    bool ok = out_->good();
+    if (seekable_) {
+        bool rf64 = kHeaderSize - 8 + data_bytes_ + (data_bytes_ & 1) > kRiffLimit;
+        auto header = build_header(rf64);
+        file_->seekp(0, std::ios::beg);
+        file_->write(reinterpret_cast<const char*>(header.data()), header.size());
+        file_->flush();
+        ok = ok && file_->good();
+        file_.reset();
+    } else {
+        out_->flush();
+        ok = ok && out_->good();
+    }
+    out_ = nullptr;
+    return ok;
+}
+
+} // namespace libste
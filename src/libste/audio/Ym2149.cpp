@@ -0,0 +1,145 @@
+#include "Ym2149.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace libste {
+
+namespace {
+
+// 5-bit DAC: 1.5 dB per step, level 0 is silence
+const std::array<float, 32>& volume_table() {
+    static const std::array<float, 32> table = [] {
+        std::array<float, 32> t{};
+        for (int i = 1; i < 32; ++i) t[i] = std::pow(10.0f, (i - 31) * 1.5f / 20.0f);
+        return t;
+    }();
+    return table;
+}
+
+} // namespace
+
+Ym2149::Ym2149(uint32_t master_clock, uint32_t sample_rate) {
+    step_ = static_cast<uint32_t>((uint64_t(master_clock / 8) << 16) / sample_rate);
+    write(7, 0xFF);
+}
+
+void Ym2149::write(int reg, uint8_t value) {
+    if (reg < 0 || reg > 15) return;
+    regs_[reg] = value;
+    switch (reg) {
+        case 0: case 1: case 2: case 3: case 4: case 5: {
+            int ch = reg / 2;
+            uint32_t period = regs_[ch * 2] | ((regs_[ch * 2 + 1] & 0x0F) << 8);
+            tone_period_[ch] = std::max<uint32_t>(period, 1);  // Half-cycle in ticks
+            break;
+        }
+        case 6:
+            // Noise shifts at half the tone rate
+            noise_period_ = std::max<uint32_t>(value & 0x1F, 1) * 2;
+            break;
+        case 11: case 12:
+            env_period_ = std::max<uint32_t>(regs_[11] | (regs_[12] << 8), 1);
+            break;
+        case 13: {
+            uint8_t shape = value & 0x0F;
+            env_attack_ = (shape & 0x04) ? 0x1F : 0x00;
+            if ((shape & 0x08) == 0) {
+                // Shapes 0-7 run once, then hold at zero
+                env_hold_ = true;
+                env_alternate_ = env_attack_;
+            } else {
+                env_hold_ = shape & 0x01;
+                env_alternate_ = shape & 0x02;
+            }
+            env_step_ = 0x1F;
+            env_count_ = 0;
+            env_holding_ = false;
+            break;
+        }
+    }
+}
+
+void Ym2149::load_frame(const std::array<uint8_t, 16>& regs) {
+    for (int r = 0; r < 13; ++r) write(r, regs[r]);
+    if (regs[13] != 0xFF) write(13, regs[13]);
+}
+
+void Ym2149::advance_envelope() {
+    if (env_holding_) return;
+    if (--env_step_ < 0) {
+        if (env_hold_) {
+            if (env_alternate_) env_attack_ ^= 0x1F;
+            env_holding_ = true;
+            env_step_ = 0;
+        } else {
+            if (env_alternate_) env_attack_ ^= 0x1F;
+            env_step_ &= 0x1F;
+        }
+    }
+}
+
+float Ym2149::level() const {
+    const auto& table = volume_table();
+    const uint8_t mixer = regs_[7];
+    const int env_volume = env_step_ ^ env_attack_;
+    float sum = 0.0f;
+    for (int ch = 0; ch < 3; ++ch) {
+        bool tone = tone_out_[ch] || (mixer & (1 << ch));
+        bool noise = noise_out_ || (mixer & (8 << ch));
+        if (!(tone && noise)) continue;
+        uint8_t vol = regs_[8 + ch];
+        int index = (vol & 0x10) ? env_volume : ((vol & 0x0F) ? (vol & 0x0F) * 2 + 1 : 0);
+        sum += table[index];
+    }
+    return sum;
+}
+
+void Ym2149::render(std::span<int16_t> out) {
+    for (auto& sample : out) {
+        frac_ += step_;
+        uint32_t ticks = frac_ >> 16;
+        frac_ &= 0xFFFF;
+
+        // Jump from edge to edge: between events the output is constant
+        float acc = 0.0f;
+        uint32_t remaining = ticks;
+        while (remaining > 0) {
+            uint32_t run = remaining;
+            for (int ch = 0; ch < 3; ++ch) run = std::min(run, tone_period_[ch] - std::min(tone_count_[ch], tone_period_[ch] - 1));
+            run = std::min(run, noise_period_ - std::min(noise_count_, noise_period_ - 1));
+            if (!env_holding_) run = std::min(run, env_period_ - std::min(env_count_, env_period_ - 1));
+
+            acc += level() * run;
+            remaining -= run;
+
+            for (int ch = 0; ch < 3; ++ch) {
+                tone_count_[ch] += run;
+                if (tone_count_[ch] >= tone_period_[ch]) {
+                    tone_count_[ch] = 0;
+                    tone_out_[ch] ^= 1;
+                }
+            }
+            noise_count_ += run;
+            if (noise_count_ >= noise_period_) {
+                noise_count_ = 0;
+                rng_ = (rng_ >> 1) | (((rng_ ^ (rng_ >> 3)) & 1) << 16);
+                noise_out_ = rng_ & 1;
+            }
+            if (!env_holding_) {
+                env_count_ += run;
+                if (env_count_ >= env_period_) {
+                    env_count_ = 0;
+                    advance_envelope();
+                }
+            }
+        }
+
+        float x = ticks ? acc / (3.0f * ticks) : dc_in_;
+        dc_out_ = x - dc_in_ + 0.995f * dc_out_;
+        dc_in_ = x;
+        int v = static_cast<int>(dc_out_ * 32767.0f);
+        sample = static_cast<int16_t>(std::clamp(v, -32768, 32767));
+    }
+}
+
+} // namespace libste
@@ -0,0 +1,112 @@
+#include "YmFile.hpp"
+#include "Lha.hpp"
+#include "BufferStore.hpp"
+#include <cstring>
+
+namespace libste {
+
+namespace {
+
+constexpr uint32_t kMaxMasterClock = 8000000;
+
+uint32_t be32(const uint8_t* p) { return (uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+
+bool read_cstring(std::span<const uint8_t> data, size_t& pos, std::string& out) {
+    size_t end = pos;
+    while (end < data.size() && data[end] != 0) ++end;
+    if (end >= data.size()) return false;
+    out.assign(reinterpret_cast<const char*>(&data[pos]), end - pos);
+    pos = end + 1;
+    return true;
+}
+
+// YM2!/YM3!: 14 registers stored register-major after the 4-byte tag (no I/O ports)
+bool parse_ym3(std::span<const uint8_t> data, YmSong& song, bool has_loop) {
+    size_t body = data.size() - 4 - (has_loop ? 4 : 0);
+    size_t frames = body / 14;
+    if (frames == 0) return false;
+    song.frames.assign(frames, {});
+    for (size_t r = 0; r < 14; ++r) {
+        const uint8_t* src = &data[4 + r * frames];
+        for (size_t f = 0; f < frames; ++f) song.frames[f][r] = src[f];
+    }
+    if (has_loop) {
+        // YM3b stores its loop frame little-endian
+        const uint8_t* p = &data[data.size() - 4];
+        song.loop_frame = p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+    }
+    return true;
+}
+
+// YM5!/YM6!: header, digidrums, strings, then 16 registers per frame
+bool parse_ym5(std::span<const uint8_t> data, YmSong& song) {
+    if (data.size() < 34 || std::memcmp(&data[4], "LeOnArD!", 8) != 0) return false;
+    uint32_t frames = be32(&data[12]);
+    uint32_t attributes = be32(&data[16]);
+    uint16_t digidrums = be16(&data[20]);
+    song.master_clock = be32(&data[22]);
+    song.frame_rate = be16(&data[26]);
+    song.loop_frame = be32(&data[28]);
+    uint16_t extra = be16(&data[32]);
+
+    size_t pos = 34 + extra;
+    for (uint16_t d = 0; d < digidrums; ++d) {
+        if (pos + 4 > data.size()) return false;
+        uint32_t size = be32(&data[pos]);
+        if (size > data.size() - pos - 4) return false;
+        pos += 4 + size;
+    }
+    if (!read_cstring(data, pos, song.name) || !read_cstring(data, pos, song.author) ||
+        !read_cstring(data, pos, song.comment)) {
+        return false;
+    }
+
+    if (frames == 0 || frames > (data.size() - pos) / 16) return false;
+    song.frames.assign(frames, {});
+    const bool interleaved = attributes & 1;
+    for (uint32_t f = 0; f < frames; ++f) {
+        for (int r = 0; r < 16; ++r) {
+            size_t idx = interleaved ? pos + size_t(r) * frames + f : pos + size_t(f) * 16 + r;
+            song.frames[f][r] = data[idx];
+        }
+    }
+    if (song.frame_rate == 0) song.frame_rate = 50;
+    if (song.master_clock == 0) song.master_clock = 2000000;
+    // Real chips run at 1-2 MHz; the emulator's work per sample grows with the clock
+    return song.master_clock <= kMaxMasterClock;
+}
+
+} // namespace
+
+bool load_ym(std::span<const uint8_t> data, YmSong& song) {
+    song = YmSong{};
+    if (data.size() < 4) return false;
+
+    // Most .YM files are LHA archives holding the actual dump
+    std::vector<uint8_t> unpacked;
+    if (data.size() > 22 && data[2] == '-' && data[3] == 'l' && data[4] == 'h') {
+        if (!lha_depack(data, unpacked)) return false;
+        data = unpacked;
+        if (data.size() < 4) return false;
+    }
+
+    if (std::memcmp(data.data(), "YM2!", 4) == 0 || std::memcmp(data.data(), "YM3!", 4) == 0) {
+        return parse_ym3(data, song, false);
+    }
+    if (std::memcmp(data.data(), "YM3b", 4) == 0) {
+        return data.size() > 8 && parse_ym3(data, song, true);
+    }
+    if (std::memcmp(data.data(), "YM5!", 4) == 0 || std::memcmp(data.data(), "YM6!", 4) == 0) {
+        return parse_ym5(data, song);
+    }
+    return false;
+}
+
+bool load_ym_file(const std::string& path, YmSong& song) {
+    std::vector<uint8_t> storage;
+    std::span<const uint8_t> data;
+    return load_input(path, storage, data) && load_ym(data, song);
+}
+
+} // namespace libste
@@ -0,0 +1,87 @@
+#include "BootSector.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace libste {
+
+namespace {
+
+constexpr size_t kPrgHeaderSize = 28;
+
+uint32_t be32(const uint8_t* p) { return (uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+
+} // namespace
+
+bool load_boot_code(std::span<const uint8_t> file, std::vector<uint8_t>& code, std::string& error) {
+    std::span<const uint8_t> body = file;
+    // GEMDOS program header: $601A, text, data, bss and symbol sizes, then flags
+    if (file.size() >= kPrgHeaderSize && file[0] == 0x60 && file[1] == 0x1A) {
+        uint64_t text = be32(&file[2]), data = be32(&file[6]), bss = be32(&file[10]), symbols = be32(&file[14]);
+        bool absolute = file[26] != 0 || file[27] != 0;
+        uint64_t image = text + data;
+        if (kPrgHeaderSize + image + symbols > file.size()) {
+            error = "program is truncated";
+            return false;
+        }
+        size_t fixups = kPrgHeaderSize + image + symbols;
+        if (!absolute && fixups + 4 <= file.size() && be32(&file[fixups]) != 0) {
+            error = "program has relocations; boot code must be position independent";
+            return false;
+        }
+        if (bss != 0) {
+            error = "program has " + std::to_string(bss) + " bytes of BSS; boot code has none";
+            return false;
+        }
+        body = file.subspan(kPrgHeaderSize, image);
+    }
+    if (body.empty()) {
+        error = "no boot code";
+        return false;
+    }
+    if (body.size() > BootSector::CODE_MAX) {
+        error = "boot code is " + std::to_string(body.size()) + " bytes; " + std::to_string(BootSector::CODE_MAX) +
+                " fit after the BPB";
+        return false;
+    }
+    code.assign(body.begin(), body.end());
+    return true;
+}
+
+bool install_boot_code(DiskHandler& disk, std::span<const uint8_t> code, std::string& error) {
+    auto sector = disk.get_sector(0);
+    if (sector.empty()) {
+        error = "image has no boot sector";
+        return false;
+    }
+    if (code.size() > BootSector::CODE_MAX) {
+        error = "boot code is " + std::to_string(code.size()) + " bytes; " + std::to_string(BootSector::CODE_MAX) +
+                " fit after the BPB";
+        return false;
+    }
+
+    // BRA.S: displacement from the end of the instruction
+    sector[0] = 0x60;
+    sector[1] = static_cast<uint8_t>(BootSector::CODE_OFFSET - 2);
+    auto area = sector.subspan(BootSector::CODE_OFFSET, BootSector::CODE_MAX);
+    std::fill(std::copy(code.begin(), code.end(), area.begin()), area.end(), 0);
+    disk.apply_tos_checksum();
+    return true;
+}
+
+void set_oem_name(DiskHandler& disk, const std::string& name) {
+    auto sector = disk.get_sector(0);
+    if (sector.empty()) return;
+    uint8_t* oem = &sector[BootSector::OEM_OFFSET];
+    std::memset(oem, ' ', BootSector::OEM_SIZE);
+    std::memcpy(oem, name.data(), std::min(name.size(), BootSector::OEM_SIZE));
+}
+
+void set_serial(DiskHandler& disk, uint32_t serial) {
+    auto sector = disk.get_sector(0);
+    if (sector.empty()) return;
+    sector[BootSector::SERIAL_OFFSET] = serial & 0xFF;
+    sector[BootSector::SERIAL_OFFSET + 1] = (serial >> 8) & 0xFF;
+    sector[BootSector::SERIAL_OFFSET + 2] = (serial >> 16) & 0xFF;
+}
+
+} // namespace libste
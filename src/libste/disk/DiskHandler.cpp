@@ -1,5 +1,6 @@
 #include "DiskHandler.hpp"
-#include <fstream>
+#include "BufferStore.hpp"
+#include "DiskStats.hpp"
 #include <numeric>
 
 namespace libste {
@@ -13,24 +14,27 @@ bool DiskHandler::create_blank(size_t size) {
 }
 
 bool DiskHandler::load_from_file(const std::string& path) {
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file) return false;
+    STE_TIME(load_ns);
+    std::vector<uint8_t> storage;
+    std::span<const uint8_t> image;
+    if (!load_input(path, storage, image)) return false;
 
-    std::streamsize size = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    data_.resize(static_cast<size_t>(size));
-    return file.read(reinterpret_cast<char*>(data_.data()), size) ? true : false;
+    // Host files move in; a pipeline buffer is copied since the image is mutable
+    if (image.data() == storage.data()) data_.swap(storage);
+    else data_.assign(image.begin(), image.end());
+    STE_COUNT(image_bytes_loaded, data_.size());
+    return true;
 }
 
 bool DiskHandler::save_to_file(const std::string& path) {
-    std::ofstream file(path, std::ios::binary);
-    if (!file) return false;
-    file.write(reinterpret_cast<const char*>(data_.data()), data_.size());
-    return file.good();
+    STE_TIME(save_ns);
+    if (!save_output(path, data_)) return false;
+    STE_COUNT(image_bytes_saved, data_.size());
+    return true;
 }
 
 std::span<uint8_t> DiskHandler::get_sector(size_t sector_index) {
+    STE_COUNT(sector_reads, 1);
     size_t offset = sector_index * SECTOR_SIZE;
     if (offset + SECTOR_SIZE > data_.size()) {
         return {}; // Out of bounds
@@ -38,6 +42,16 @@ std::span<uint8_t> DiskHandler::get_sector(size_t sector_index) {
     return std::span<uint8_t>(&data_[offset], SECTOR_SIZE);
 }
 
+std::span<uint8_t> DiskHandler::get_sectors(size_t first_sector, size_t count) {
+    STE_COUNT(sector_reads, 1);
+    size_t offset = first_sector * SECTOR_SIZE;
+    size_t bytes = count * SECTOR_SIZE;
+    if (count == 0 || offset + bytes > data_.size()) {
+        return {};
+    }
+    return std::span<uint8_t>(&data_[offset], bytes);
+}
+
 void DiskHandler::apply_tos_checksum() {
     if (data_.size() < SECTOR_SIZE) return;
 
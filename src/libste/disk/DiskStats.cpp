@@ -0,0 +1,83 @@
+#include "DiskStats.hpp"
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+namespace libste {
+
+#if STE_STATS
+namespace detail {
+DiskStats g_stats;
+} // namespace detail
+#endif
+
+DiskStats stats_snapshot() {
+#if STE_STATS
+    return detail::g_stats;
+#else
+    return {};
+#endif
+}
+
+void reset_stats() {
+#if STE_STATS
+    detail::g_stats = {};
+#endif
+}
+
+void print_stats(std::ostream& out, const DiskStats& s) {
+    if (!stats_enabled()) {
+        out << "stats: not compiled in (configure with -DSTE_STATS=ON)\n";
+        return;
+    }
+    auto count = [&out](const char* label, uint64_t value) {
+        out << "  " << std::left << std::setw(22) << label << std::right << std::setw(12) << value << "\n";
+    };
+    auto time = [&out](const char* label, uint64_t ns) {
+        out << "  " << std::left << std::setw(22) << label << std::right << std::setw(12) << std::fixed
+            << std::setprecision(3) << ns / 1e6 << " ms\n" << std::defaultfloat;
+    };
+
+    out << "--- ste_core stats ---\n";
+    count("sector reads", s.sector_reads);
+    count("FAT lookups", s.fat_lookups);
+    count("FAT updates", s.fat_updates);
+    count("FAT mirrors", s.fat_mirrors);
+    count("  bytes mirrored", s.fat_mirror_bytes);
+    count("free-cluster scans", s.free_cluster_scans);
+    count("  entries probed", s.free_cluster_probes);
+    count("directory scans", s.dir_scans);
+    count("  slots examined", s.dir_entries);
+    count("image bytes loaded", s.image_bytes_loaded);
+    count("image bytes saved", s.image_bytes_saved);
+    count("file bytes read", s.file_bytes_read);
+    count("file bytes written", s.file_bytes_written);
+    time("load", s.load_ns);
+    time("save", s.save_ns);
+    time("directory scans", s.dir_scan_ns);
+    time("free-cluster scans", s.free_scan_ns);
+    time("extract", s.extract_ns);
+    time("inject", s.inject_ns);
+}
+
+bool take_stats_flag(int& argc, char* argv[]) {
+    bool found = false;
+    int out = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--stats") == 0) found = true;
+        else argv[out++] = argv[i];
+    }
+    argc = out;
+    argv[argc] = nullptr;
+    return found;
+}
+
+StatsReport::StatsReport(bool enabled) : enabled_(enabled) {
+    if (enabled_) reset_stats();
+}
+
+StatsReport::~StatsReport() {
+    if (enabled_) print_stats(std::cerr, stats_snapshot());
+}
+
+} // namespace libste
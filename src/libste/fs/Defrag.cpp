@@ -0,0 +1,248 @@
+#include "Defrag.hpp"
+#include "Fat12Driver.hpp"
+#include "FsCheck.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace libste {
+
+namespace {
+
+constexpr uint16_t kEndOfChain = 0xFFF;
+constexpr uint16_t kBadCluster = 0xFF7;
+constexpr size_t kEntrySize = 32;
+
+uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+void put_le16(uint8_t* p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+
+std::string entry_name(const uint8_t* e) {
+    std::string name(reinterpret_cast<const char*>(e), 8);
+    std::string ext(reinterpret_cast<const char*>(e + 8), 3);
+    name.erase(name.find_last_not_of(' ') + 1);
+    ext.erase(ext.find_last_not_of(' ') + 1);
+    return ext.empty() ? name : name + "." + ext;
+}
+
+std::string normalize_path(std::string path) {
+    for (char& c : path) c = (c == '/') ? '\\' : static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    while (!path.empty() && path[0] == '\\') path.erase(0, 1);
+    return path;
+}
+
+// A file or directory: where its entry lives and the clusters it owns
+struct Node {
+    std::string path;
+    size_t sector, offset;
+    bool is_dir;
+    int parent;  // Index of the containing directory, -1 for the root
+    std::vector<uint16_t> chain;
+};
+
+std::vector<size_t> chain_sectors(const std::vector<uint16_t>& chain) {
+    std::vector<size_t> sectors;
+    for (uint16_t c : chain) {
+        for (size_t i = 0; i < Fat12Driver::SECTORS_PER_CLUSTER; ++i) sectors.push_back(Fat12Driver::cluster_sector(c) + i);
+    }
+    return sectors;
+}
+
+// Pre-order walk: each directory is followed by its contents
+void collect(DiskHandler& disk, Fat12Driver& fat, const std::vector<size_t>& sectors, int parent,
+             const std::string& prefix, std::vector<Node>& nodes) {
+    for (size_t s : sectors) {
+        auto sector = disk.get_sector(s);
+        if (sector.empty()) continue;
+        for (size_t off = 0; off < sector.size(); off += kEntrySize) {
+            const uint8_t* e = &sector[off];
+            if (e[0] == 0x00) return;
+            if (e[0] == 0xE5 || e[0] == '.' || (e[11] & 0x08)) continue;
+
+            Node node{ prefix + entry_name(e), s, off, (e[11] & 0x10) != 0, parent, {} };
+            uint16_t start = le16(e + 26);
+            if (start != 0) fat.get_chain(start, node.chain);
+            nodes.push_back(std::move(node));
+            if (nodes.back().is_dir) {
+                int self = static_cast<int>(nodes.size() - 1);
+                collect(disk, fat, chain_sectors(nodes[self].chain), self, nodes[self].path + "\\", nodes);
+            }
+        }
+    }
+}
+
+size_t count_extents(const std::vector<uint16_t>& chain) {
+    size_t extents = chain.empty() ? 0 : 1;
+    for (size_t i = 1; i < chain.size(); ++i) {
+        if (chain[i] != chain[i - 1] + 1) ++extents;
+    }
+    return extents;
+}
+
+} // namespace
+
+bool defragment(DiskHandler& disk, const DefragOptions& options, DefragResult& result, std::string& error) {
+    result = DefragResult{};
+
+    FsCheckReport check = check_filesystem(disk, false);
+    for (const auto& p : check.problems) {
+        if (p.kind != FsProblemKind::FatCopyMismatch) {
+            error = std::string("filesystem has problems (") + to_string(p.kind) + "); run st-check --repair first";
+            return false;
+        }
+    }
+
+    Fat12Driver fat(disk);
+    const uint16_t limit = fat.cluster_limit();
+    std::vector<Node> nodes;
+    std::vector<size_t> root;
+    for (size_t i = 0; i < Fat12Driver::ROOT_DIR_SECTORS; ++i) root.push_back(Fat12Driver::ROOT_DIR_START + i);
+    collect(disk, fat, root, -1, "", nodes);
+
+    // Geometry for track alignment and the seek estimate
+    auto boot = disk.get_sector(0);
+    size_t per_track = le16(&boot[0x18]);
+    size_t sides = le16(&boot[0x1A]);
+    if (per_track == 0 || per_track > 63) per_track = 9;
+    if (sides == 0 || sides > 2) sides = 2;
+
+    // Placement order: the load order list, then directory order
+    std::vector<int> order;
+    std::vector<bool> placed(nodes.size(), false);
+    auto find_node = [&](const std::string& path) {
+        std::string wanted = normalize_path(path);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].path == wanted) return static_cast<int>(i);
+        }
+        return -1;
+    };
+    for (const auto& path : options.load_order) {
+        int n = find_node(path);
+        if (n < 0) {
+            error = "not on the disk: " + path;
+            return false;
+        }
+        if (!placed[n]) order.push_back(n);
+        placed[n] = true;
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!placed[i]) order.push_back(static_cast<int>(i));
+    }
+    std::vector<bool> aligned(nodes.size(), false);
+    for (const auto& path : options.track_aligned) {
+        int n = find_node(path);
+        if (n < 0) {
+            error = "not on the disk: " + path;
+            return false;
+        }
+        aligned[n] = true;
+    }
+
+    // The plan: dest[old] = new cluster. Owned clusters are packed in order,
+    // bad clusters stay put, and the remaining (free) clusters fill the gaps
+    // so that dest is a full permutation.
+    std::vector<uint16_t> dest(limit, 0);
+    std::vector<bool> bad(limit, false), taken(limit, false), assigned(limit, false);
+    for (uint16_t c = 2; c < limit; ++c) {
+        if (fat.get_fat_entry(c) == kBadCluster) {
+            bad[c] = taken[c] = assigned[c] = true;
+            dest[c] = c;
+        }
+    }
+    uint16_t next = 2;
+    for (int n : order) {
+        const Node& node = nodes[n];
+        if (node.chain.empty()) continue;
+        if (aligned[n]) {
+            while (next < limit && Fat12Driver::cluster_sector(next) % per_track != 0) ++next;
+        }
+        for (uint16_t old : node.chain) {
+            while (next < limit && bad[next]) ++next;
+            if (next >= limit) {
+                error = "no room left for " + node.path + " (track alignment needs free clusters)";
+                return false;
+            }
+            dest[old] = next;
+            assigned[old] = taken[next] = true;
+            ++next;
+        }
+    }
+    uint16_t slot = 2;
+    for (uint16_t c = 2; c < limit; ++c) {
+        if (assigned[c]) continue;
+        while (taken[slot]) ++slot;
+        dest[c] = slot;
+        taken[slot] = true;
+    }
+
+    // Seek estimate: read every file in load order, count cylinder changes
+    const size_t per_cylinder = per_track * sides;
+    auto seeks = [&](bool after) {
+        size_t count = 0, cylinder = SIZE_MAX;
+        for (int n : order) {
+            if (nodes[n].is_dir) continue;
+            for (uint16_t c : nodes[n].chain) {
+                size_t cyl = Fat12Driver::cluster_sector(after ? dest[c] : c) / per_cylinder;
+                if (cyl != cylinder) {
+                    if (cylinder != SIZE_MAX) ++count;
+                    cylinder = cyl;
+                }
+            }
+        }
+        return count;
+    };
+    result.seeks_before = seeks(false);
+    result.seeks_after = seeks(true);
+
+    // 1. Directory entries, still at their old places (they move with step 2)
+    for (const Node& node : nodes) {
+        node.is_dir ? ++result.directories : ++result.files;
+        result.extents_before += count_extents(node.chain);
+        if (node.chain.empty()) continue;
+        put_le16(&disk.get_sector(node.sector)[node.offset + 26], dest[node.chain[0]]);
+        if (!node.is_dir) continue;
+        uint16_t parent = node.parent >= 0 ? dest[nodes[node.parent].chain[0]] : 0;
+        for (size_t s : chain_sectors(node.chain)) {
+            auto sector = disk.get_sector(s);
+            for (size_t off = 0; off < sector.size(); off += kEntrySize) {
+                uint8_t* e = &sector[off];
+                if (e[0] != '.') continue;
+                put_le16(e + 26, e[1] == '.' ? parent : dest[node.chain[0]]);
+            }
+        }
+    }
+
+    // 2. Cluster data: follow each cycle of the permutation, carrying one cluster
+    std::vector<uint8_t> carry(Fat12Driver::CLUSTER_SIZE);
+    auto cluster_data = [&disk](uint16_t c) { return disk.get_sector(Fat12Driver::cluster_sector(c)).data(); };
+    std::vector<bool> done(limit, false);
+    for (uint16_t start = 2; start < limit; ++start) {
+        if (done[start] || dest[start] == start) continue;
+        std::memcpy(carry.data(), cluster_data(start), carry.size());
+        uint16_t cur = start;
+        do {
+            uint16_t to = dest[cur];
+            std::swap_ranges(carry.begin(), carry.end(), cluster_data(to));
+            done[cur] = true;
+            ++result.clusters_moved;
+            cur = to;
+        } while (cur != start);
+    }
+
+    // 3. FATs: every chain is now a straight run
+    for (uint16_t c = 2; c < limit; ++c) {
+        if (!bad[c]) fat.set_fat_entry(c, 0);
+    }
+    for (const Node& node : nodes) {
+        for (size_t i = 0; i < node.chain.size(); ++i) {
+            uint16_t c = dest[node.chain[i]];
+            fat.set_fat_entry(c, i + 1 < node.chain.size() ? dest[node.chain[i + 1]] : kEndOfChain);
+        }
+        std::vector<uint16_t> moved(node.chain.size());
+        for (size_t i = 0; i < node.chain.size(); ++i) moved[i] = dest[node.chain[i]];
+        result.extents_after += count_extents(moved);
+    }
+    fat.sync_fat_copies();
+    return true;
+}
+
+} // namespace libste
@@ -0,0 +1,310 @@
+#include "DiskSync.hpp"
+#include "Fat12Driver.hpp"
+#include "DiskStats.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace libste {
+
+namespace {
+
+constexpr size_t kEntrySize = 32;
+constexpr size_t kRootEntries = Fat12Driver::ROOT_DIR_SECTORS * DiskHandler::SECTOR_SIZE / kEntrySize;
+
+struct HostNode {
+    std::string name;  // 8.3, as it goes on the disk
+    fs::path path;
+    bool is_dir = false;
+    uint64_t size = 0;
+    std::vector<HostNode> children;
+    uint16_t start = 0;
+    size_t clusters = 0;
+};
+
+size_t clusters_for(uint64_t bytes) {
+    return static_cast<size_t>((bytes + Fat12Driver::CLUSTER_SIZE - 1) / Fat12Driver::CLUSTER_SIZE);
+}
+
+// Reads one host directory level into `dir`, recursing into subdirectories
+bool scan(HostNode& dir, std::string& error) {
+    std::error_code ec;
+    std::set<std::string> names;
+    for (fs::directory_iterator it(dir.path, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string host = it->path().filename().string();
+        if (host[0] == '.') continue;
+
+        HostNode node;
+        node.path = it->path();
+        if (!to_83(host, node.name)) {
+            error = "not an 8.3 name: " + node.path.string();
+            return false;
+        }
+        if (!names.insert(node.name).second) {
+            error = "two host files map to " + node.name + " in " + dir.path.string();
+            return false;
+        }
+        node.is_dir = it->is_directory(ec);
+        if (node.is_dir) {
+            if (!scan(node, error)) return false;
+        } else {
+            node.size = it->file_size(ec);
+        }
+        if (ec) break;
+        dir.children.push_back(std::move(node));
+    }
+    if (ec) {
+        error = "cannot read " + dir.path.string() + ": " + ec.message();
+        return false;
+    }
+    std::sort(dir.children.begin(), dir.children.end(),
+              [](const HostNode& a, const HostNode& b) { return a.name < b.name; });
+    return true;
+}
+
+// Sizes every node and hands out clusters in pre-order: a subdirectory's
+// own cluster(s), then its contents, then its next sibling
+void place(HostNode& dir, size_t& next, SyncResult& result) {
+    for (HostNode& node : dir.children) {
+        if (node.is_dir) {
+            node.clusters = clusters_for((node.children.size() + 2) * kEntrySize);
+            ++result.directories;
+        } else {
+            node.clusters = clusters_for(node.size);
+            result.bytes += node.size;
+            ++result.files;
+        }
+        // Past the end of the disk only until the capacity check fails
+        node.start = node.clusters ? static_cast<uint16_t>(next) : 0;
+        next += node.clusters;
+        if (node.is_dir) place(node, next, result);
+    }
+}
+
+size_t count_clusters(const HostNode& dir) {
+    size_t total = 0;
+    for (const HostNode& node : dir.children) {
+        total += node.clusters;
+        if (node.is_dir) total += count_clusters(node);
+    }
+    return total;
+}
+
+void write_entry(uint8_t* e, const std::string& name, uint8_t attributes, uint16_t start, uint32_t size) {
+    std::memset(e, 0, kEntrySize);
+    std::memset(e, 0x20, 11);
+    size_t dot = name.find('.');
+    if (name[0] == '.') dot = std::string::npos;  // "." and ".."
+    std::memcpy(e, name.data(), std::min(dot, name.size()));
+    if (dot != std::string::npos) std::memcpy(e + 8, name.data() + dot + 1, name.size() - dot - 1);
+    e[11] = attributes;
+    e[26] = start & 0xFF; e[27] = start >> 8;
+    e[28] = size & 0xFF; e[29] = (size >> 8) & 0xFF;
+    e[30] = (size >> 16) & 0xFF; e[31] = (size >> 24) & 0xFF;
+}
+
+std::span<uint8_t> cluster_run(DiskHandler& disk, uint16_t start, size_t clusters) {
+    return disk.get_sectors(Fat12Driver::cluster_sector(start), clusters * Fat12Driver::SECTORS_PER_CLUSTER);
+}
+
+// Fills the directory area `slots` with the entries of `dir` and writes
+// everything below it. `self` and `parent` are for "." and ".." (0 = root).
+bool write_tree(DiskHandler& disk, Fat12Driver& fat, const HostNode& dir, std::span<uint8_t> slots, uint16_t self,
+                uint16_t parent, std::string& error) {
+    std::fill(slots.begin(), slots.end(), 0);
+    uint8_t* e = slots.data();
+    if (self != 0) {
+        write_entry(e, ".", 0x10, self, 0);
+        write_entry(e + kEntrySize, "..", 0x10, parent, 0);
+        e += 2 * kEntrySize;
+    }
+
+    for (const HostNode& node : dir.children) {
+        write_entry(e, node.name, node.is_dir ? 0x10 : 0x00, node.start, static_cast<uint32_t>(node.size));
+        e += kEntrySize;
+        for (size_t i = 0; i < node.clusters; ++i) {
+            uint16_t c = static_cast<uint16_t>(node.start + i);
+            fat.set_fat_entry(c, i + 1 < node.clusters ? c + 1 : 0xFFF);
+        }
+        if (node.clusters == 0) continue;
+
+        auto run = cluster_run(disk, node.start, node.clusters);
+        if (node.is_dir) {
+            if (!write_tree(disk, fat, node, run, node.start, self, error)) return false;
+            continue;
+        }
+        std::ifstream in(node.path, std::ios::binary);
+        in.read(reinterpret_cast<char*>(run.data()), static_cast<std::streamsize>(node.size));
+        if (static_cast<uint64_t>(in.gcount()) != node.size) {
+            error = "could not read " + node.path.string();
+            return false;
+        }
+        std::fill(run.begin() + node.size, run.end(), 0);
+        STE_COUNT(file_bytes_written, node.size);
+    }
+    return true;
+}
+
+// One host file to write: its data as runs of consecutive clusters
+struct ExtractJob {
+    fs::path dest;
+    std::vector<std::span<const uint8_t>> extents;
+};
+
+// True if `path` resolves (symlinks included) to somewhere below `root`,
+// which must already be canonical
+bool is_inside(const fs::path& root, const fs::path& path) {
+    std::error_code ec;
+    fs::path resolved = fs::weakly_canonical(fs::absolute(path, ec), ec);
+    if (ec) return false;
+    auto mismatch = std::mismatch(root.begin(), root.end(), resolved.begin(), resolved.end());
+    return mismatch.first == root.end() && mismatch.second != resolved.end();
+}
+
+bool collect(DiskHandler& disk, Fat12Driver& fat, uint16_t start, const fs::path& root, const fs::path& dest,
+             std::set<uint16_t>& visited, std::vector<ExtractJob>& jobs, SyncResult& result, std::string& error) {
+    std::error_code ec;
+    fs::create_directories(dest, ec);
+    if (ec) {
+        error = "cannot create " + dest.string() + ": " + ec.message();
+        return false;
+    }
+    for (const DirEntry& entry : fat.list_directory(start)) {
+        // Keep a crafted image from writing outside host_dir: a name built
+        // from blanks and dots can decode to "..", so only legal 8.3 names
+        // pass, and the result must still resolve below host_dir
+        std::string checked;
+        fs::path path = dest / entry.filename;
+        if (!to_83(entry.filename, checked)) {
+            error = "unsafe name on the disk: '" + entry.filename + "'";
+            return false;
+        }
+        if (!is_inside(root, path)) {
+            error = path.string() + " leads outside " + root.string();
+            return false;
+        }
+        if (entry.attributes & 0x10) {
+            // A directory reached twice would recurse forever
+            if (entry.start_cluster == 0 || !visited.insert(entry.start_cluster).second) {
+                error = "directory loop at " + path.string() + "; run st-check --repair";
+                return false;
+            }
+            ++result.directories;
+            if (!collect(disk, fat, entry.start_cluster, root, path, visited, jobs, result, error)) return false;
+            continue;
+        }
+
+        size_t needed = clusters_for(entry.size);
+        std::vector<uint16_t> chain;
+        if (needed > 0 && (!fat.get_chain(entry.start_cluster, chain, needed) || chain.size() < needed)) {
+            error = "broken chain in " + path.string() + "; run st-check --repair";
+            return false;
+        }
+        ExtractJob job{ path, {} };
+        uint32_t remaining = entry.size;
+        for (size_t i = 0; i < chain.size();) {
+            size_t run = 1;
+            while (i + run < chain.size() && chain[i + run] == chain[i] + run) ++run;
+            size_t bytes = std::min<size_t>(run * Fat12Driver::CLUSTER_SIZE, remaining);
+            job.extents.push_back(cluster_run(disk, chain[i], run).first(bytes));
+            remaining -= static_cast<uint32_t>(bytes);
+            i += run;
+        }
+        jobs.push_back(std::move(job));
+        result.clusters += needed;
+        result.bytes += entry.size;
+        ++result.files;
+    }
+    return true;
+}
+
+} // namespace
+
+bool build_from_tree(DiskHandler& disk, const std::string& host_dir, SyncResult& result, std::string& error) {
+    result = SyncResult{};
+    HostNode root;
+    root.path = host_dir;
+    if (!fs::is_directory(root.path)) {
+        error = "not a directory: " + host_dir;
+        return false;
+    }
+    if (!scan(root, error)) return false;
+    if (root.children.size() > kRootEntries) {
+        error = std::to_string(root.children.size()) + " entries in the top directory; the root holds " +
+                std::to_string(kRootEntries);
+        return false;
+    }
+
+    // Measure everything before the first write
+    Fat12Driver fat(disk);
+    size_t next = 2;
+    place(root, next, result);
+    result.clusters = count_clusters(root);
+    size_t capacity = fat.cluster_limit() - 2;
+    if (result.clusters > capacity) {
+        error = "tree needs " + std::to_string(result.clusters) + " KB, the disk holds " + std::to_string(capacity) +
+                " KB";
+        return false;
+    }
+
+    bool bootable = disk.verify_tos_checksum();
+    fat.format();
+    if (bootable) disk.apply_tos_checksum();  // The BPB may have changed
+    auto root_slots = disk.get_sectors(Fat12Driver::ROOT_DIR_START, Fat12Driver::ROOT_DIR_SECTORS);
+    if (!write_tree(disk, fat, root, root_slots, 0, 0, error)) return false;
+    fat.flush();
+    return true;
+}
+
+bool extract_to_tree(DiskHandler& disk, const std::string& host_dir, unsigned jobs, SyncResult& result,
+                     std::string& error) {
+    result = SyncResult{};
+    Fat12Driver fat(disk);
+    std::set<uint16_t> visited;
+    std::vector<ExtractJob> work;
+    std::error_code ec;
+    fs::path root = fs::weakly_canonical(fs::absolute(host_dir, ec), ec);
+    if (ec) {
+        error = "cannot resolve " + host_dir + ": " + ec.message();
+        return false;
+    }
+    if (!collect(disk, fat, 0, root, host_dir, visited, work, result, error)) return false;
+
+    // Workers only read the resolved spans and write host files
+    std::atomic<size_t> next{0};
+    std::vector<char> ok(work.size(), 0);
+    auto write_files = [&]() {
+        for (size_t i; (i = next++) < work.size();) {
+            std::ofstream out(work[i].dest, std::ios::binary);
+            for (auto extent : work[i].extents) {
+                out.write(reinterpret_cast<const char*>(extent.data()), static_cast<std::streamsize>(extent.size()));
+            }
+            ok[i] = out.good();
+        }
+    };
+    int workers = jobs ? int(jobs) : std::clamp(int(std::thread::hardware_concurrency()), 1, 16);
+    workers = std::clamp(workers, 1, std::max(1, int(work.size())));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < workers; ++t) pool.emplace_back(write_files);
+    write_files();
+    for (auto& th : pool) th.join();
+
+    for (size_t i = 0; i < work.size(); ++i) {
+        if (!ok[i]) {
+            error = "could not write " + work[i].dest.string();
+            return false;
+        }
+    }
+    STE_COUNT(file_bytes_read, result.bytes);
+    return true;
+}
+
+} // namespace libste
@@ -1,15 +1,16 @@
 #include "Fat12Driver.hpp"
+#include "BufferStore.hpp"
+#include "DiskStats.hpp"
+#include <cctype>
 #include <cstring>
-#include <fstream>
+#include <ostream>
 #include <algorithm>
 
 namespace libste {
 
-Fat12Driver::Fat12Driver(DiskHandler& disk) : disk_(disk) {}
+namespace {
 
-uint16_t Fat12Driver::get_fat_entry(uint16_t cluster) {
-    auto fat = disk_.get_sector(1);
-    if (fat.empty()) return 0xFFF;
+uint16_t read_entry(const uint8_t* fat, uint16_t cluster) {
     size_t offset = (cluster * 3) / 2;
     if (cluster % 2 == 0) {
         return fat[offset] | ((fat[offset + 1] & 0x0F) << 8);
@@ -18,10 +19,63 @@ uint16_t Fat12Driver::get_fat_entry(uint16_t cluster) {
     }
 }
 
+// "NAME.EXT" as the space-padded 11 bytes of a directory entry
+void encode_name(const std::string& filename, uint8_t* raw) {
+    std::memset(raw, 0x20, 11);
+    size_t dot = filename.find('.');
+    std::string base = filename.substr(0, dot);
+    std::string ext = (dot != std::string::npos) ? filename.substr(dot + 1) : "";
+    std::memcpy(raw, base.c_str(), std::min((size_t)8, base.length()));
+    std::memcpy(raw + 8, ext.c_str(), std::min((size_t)3, ext.length()));
+}
+
+} // namespace
+
+bool to_83(const std::string& host, std::string& name) {
+    static const std::string kAllowed = "!#$%&'()-@^_`{}~";
+    name.clear();
+    for (char c : host) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c != '.' && !std::isalnum(u) && kAllowed.find(c) == std::string::npos) return false;
+        name += static_cast<char>(std::toupper(u));
+    }
+    size_t dot = name.find('.');
+    size_t base = std::min(dot, name.size());
+    if (base == 0 || base > 8) return false;
+    if (dot == std::string::npos) return true;
+    std::string ext = name.substr(dot + 1);
+    return !ext.empty() && ext.size() <= 3 && ext.find('.') == std::string::npos;
+}
+
+Fat12Driver::Fat12Driver(DiskHandler& disk) : disk_(disk) {}
+
+uint16_t Fat12Driver::cluster_limit() const {
+    size_t sectors = disk_.get_total_size() / DiskHandler::SECTOR_SIZE;
+    if (sectors <= DATA_START) return 2;
+    const size_t fat_entries = FAT_SECTORS * DiskHandler::SECTOR_SIZE * 2 / 3;
+    return static_cast<uint16_t>(std::min(2 + (sectors - DATA_START) / SECTORS_PER_CLUSTER, fat_entries));
+}
+
+uint16_t Fat12Driver::get_fat_entry(uint16_t cluster) {
+    STE_COUNT(fat_lookups, 1);
+    if (!spend(1)) return 0xFFF;
+    if (cluster >= cluster_limit()) return 0xFF7;
+    // cluster_limit() keeps the offset inside the FAT
+    return read_entry(fat_copy(0).data(), cluster);
+}
+
 void Fat12Driver::set_fat_entry(uint16_t cluster, uint16_t value) {
-    auto fat = disk_.get_sector(1);
-    if (fat.empty()) return;
+    STE_COUNT(fat_updates, 1);
+    if (cluster >= cluster_limit()) return;
+    uint8_t* fat = fat_copy(0).data();
+    if (free_known_) {
+        bool was_free = read_entry(fat, cluster) == 0x000;
+        if (was_free && value != 0x000) --free_count_;
+        if (!was_free && value == 0x000) ++free_count_;
+    }
     size_t offset = (cluster * 3) / 2;
+    dirty_begin_ = std::min(dirty_begin_, offset);
+    dirty_end_ = std::max(dirty_end_, offset + 2);
     if (cluster % 2 == 0) {
         fat[offset] = value & 0xFF;
         fat[offset + 1] = (fat[offset + 1] & 0xF0) | ((value >> 8) & 0x0F);
@@ -32,20 +86,114 @@ void Fat12Driver::set_fat_entry(uint16_t cluster, uint16_t value) {
 }
 
 uint16_t Fat12Driver::find_free_cluster() {
-    for (uint16_t c = 2; c < 1440; ++c) {
+    STE_TIME(free_scan_ns);
+    STE_COUNT(free_cluster_scans, 1);
+    const uint16_t limit = cluster_limit();
+    for (uint16_t c = 2; c < limit; ++c) {
+        STE_COUNT(free_cluster_probes, 1);
         if (get_fat_entry(c) == 0x000) return c;
+        if (exhausted_) break;
     }
     return 0;
 }
 
+size_t Fat12Driver::free_chain(uint16_t start) {
+    const uint16_t limit = cluster_limit();
+    size_t freed = 0;
+    uint16_t cluster = start;
+    while (cluster >= 2 && cluster < limit) {
+        uint16_t next = get_fat_entry(cluster);
+        // Already free (or looped back to a cleared cluster), or bad: not ours to free
+        if (exhausted_ || next == 0x000 || next == 0xFF7) break;
+        set_fat_entry(cluster, 0x000);
+        ++freed;
+        cluster = next;
+    }
+    return freed;
+}
+
+size_t Fat12Driver::free_clusters() {
+    if (free_known_) return free_count_;
+    STE_TIME(free_scan_ns);
+    STE_COUNT(free_cluster_scans, 1);
+    const uint16_t limit = cluster_limit();
+    size_t count = 0;
+    for (uint16_t c = 2; c < limit; ++c) {
+        STE_COUNT(free_cluster_probes, 1);
+        if (get_fat_entry(c) == 0x000) ++count;
+    }
+    if (exhausted_) return count;
+    free_count_ = count;
+    free_known_ = true;
+    return free_count_;
+}
+
+void Fat12Driver::mirror(size_t begin, size_t end) {
+    auto first = fat_copy(0);
+    for (size_t copy = 1; copy < FAT_COPIES; ++copy) {
+        auto other = fat_copy(copy);
+        if (other.empty()) break;
+        std::memcpy(other.data() + begin, first.data() + begin, end - begin);
+        STE_COUNT(fat_mirrors, 1);
+        STE_COUNT(fat_mirror_bytes, end - begin);
+    }
+    dirty_begin_ = SIZE_MAX;
+    dirty_end_ = 0;
+}
+
+void Fat12Driver::flush() {
+    if (dirty_begin_ < dirty_end_) mirror(dirty_begin_, dirty_end_);
+}
+
+void Fat12Driver::sync_fat_copies() {
+    mirror(0, FAT_SECTORS * DiskHandler::SECTOR_SIZE);
+}
+
+bool Fat12Driver::get_chain(uint16_t start, std::vector<uint16_t>& chain, size_t max_length) {
+    chain.clear();
+    if (max_length == 0) return true;
+    const uint16_t limit = cluster_limit();
+    std::vector<bool> seen(limit, false);
+    uint16_t cluster = start;
+    while (true) {
+        if (cluster < 2 || cluster >= limit || seen[cluster]) return false;
+        seen[cluster] = true;
+        chain.push_back(cluster);
+        if (chain.size() == max_length) return true;
+        uint16_t next = get_fat_entry(cluster);
+        if (exhausted_) return false;
+        if (next >= 0xFF8) return true;  // End of chain
+        cluster = next;
+    }
+}
+
 std::vector<DirEntry> Fat12Driver::list_root_directory() {
+    return list_directory(0);
+}
+
+std::vector<DirEntry> Fat12Driver::list_directory(uint16_t start_cluster) {
+    STE_TIME(dir_scan_ns);
+    STE_COUNT(dir_scans, 1);
+    std::vector<size_t> sectors;
+    if (start_cluster == 0) {
+        for (size_t s = ROOT_DIR_START; s < ROOT_DIR_START + ROOT_DIR_SECTORS; ++s) sectors.push_back(s);
+    } else {
+        std::vector<uint16_t> chain;
+        get_chain(start_cluster, chain);
+        for (uint16_t c : chain) {
+            for (size_t i = 0; i < SECTORS_PER_CLUSTER; ++i) sectors.push_back(cluster_sector(c) + i);
+        }
+    }
+
     std::vector<DirEntry> entries;
-    for (int s = 11; s <= 17; ++s) {
+    for (size_t s : sectors) {
         auto sector = disk_.get_sector(s);
         if (sector.empty()) continue;
         for (int i = 0; i < 512; i += 32) {
+            STE_COUNT(dir_entries, 1);
+            if (!spend(1)) return entries;
             if (sector[i] == 0x00) return entries;
-            if (sector[i] == 0xE5 || (sector[i+11] & 0x08)) continue;
+            if (sector[i] == 0xE5 || sector[i] == '.' || (sector[i+11] & 0x08)) continue;
             
             DirEntry entry;
             char raw_name[9], raw_ext[4];
@@ -59,6 +207,7 @@ std::vector<DirEntry> Fat12Driver::list_root_directory() {
 
             entry.filename = name + (ext.empty() ? "" : "." + ext);
             entry.start_cluster = sector[i+26] | (sector[i+27] << 8);
+            entry.attributes = sector[i+11];
             entry.size = sector[i+28] | (sector[i+29] << 8) | (sector[i+30] << 16) | (sector[i+31] << 24);
             entries.push_back(entry);
         }
@@ -67,6 +216,7 @@ std::vector<DirEntry> Fat12Driver::list_root_directory() {
 }
 
 bool Fat12Driver::extract_file(const std::string& filename_on_disk, const std::string& local_dest_path) {
+    STE_TIME(extract_ns);
     auto entries = list_root_directory();
     auto it = std::find_if(entries.begin(), entries.end(), [&](const DirEntry& e) {
         return e.filename == filename_on_disk;
@@ -74,76 +224,210 @@ bool Fat12Driver::extract_file(const std::string& filename_on_disk, const std::s
 
     if (it == entries.end()) return false;
 
-    std::ofstream ofs(local_dest_path, std::ios::binary);
+    auto ofs = open_output_stream(local_dest_path);
     if (!ofs) return false;
 
-    uint16_t current_cluster = it->start_cluster;
+    // Only walk as far as the size needs; a loop or bad link fails the extract
+    std::vector<uint16_t> chain;
     uint32_t bytes_remaining = it->size;
+    bool chain_ok = get_chain(it->start_cluster, chain, (size_t(bytes_remaining) + CLUSTER_SIZE - 1) / CLUSTER_SIZE);
 
-    while (current_cluster >= 0x002 && current_cluster <= 0xFEF) {
+    for (uint16_t cluster : chain) {
         for (int i = 0; i < 2 && bytes_remaining > 0; ++i) {
-            auto sector = disk_.get_sector(18 + (current_cluster - 2) * 2 + i);
+            auto sector = disk_.get_sector(cluster_sector(cluster) + i);
             uint32_t to_write = std::min((uint32_t)512, bytes_remaining);
-            ofs.write((char*)sector.data(), to_write);
+            ofs->write((char*)sector.data(), to_write);
+            STE_COUNT(file_bytes_read, to_write);
             bytes_remaining -= to_write;
         }
-        if (bytes_remaining == 0) break;
-        current_cluster = get_fat_entry(current_cluster);
     }
-    return true;
+    return chain_ok && bytes_remaining == 0 && ofs->good();
 }
 
 bool Fat12Driver::inject_file(const std::string& local_path, std::string target_name) {
-    std::ifstream ifs(local_path, std::ios::binary | std::ios::ate);
-    if (!ifs) return false;
-    uint32_t file_size = ifs.tellg();
-    ifs.seekg(0, std::ios::beg);
-    std::vector<uint8_t> buffer(file_size);
-    ifs.read((char*)buffer.data(), file_size);
-
-    int entry_sector = -1, entry_offset = -1;
-    for (int s = 11; s <= 17 && entry_sector == -1; ++s) {
-        auto sector = disk_.get_sector(s);
-        for (int i = 0; i < 512; i += 32) {
-            if (sector[i] == 0x00 || sector[i] == 0xE5) {
-                entry_sector = s; entry_offset = i; break;
-            }
+    STE_TIME(inject_ns);
+    std::string name;
+    if (!to_83(target_name, name)) return false;
+    std::vector<uint8_t> storage;
+    std::span<const uint8_t> buffer;
+    if (!load_input(local_path, storage, buffer)) return false;
+    uint32_t file_size = buffer.size();
+
+    // An existing file keeps its clusters if its chain is intact
+    std::vector<uint16_t> clusters;
+    uint16_t old_start = 0;
+    bool old_broken = false;
+    uint8_t* entry = find_entry(name);
+    if (entry) {
+        if (entry[11] & 0x10) return false;
+        old_start = entry[26] | (entry[27] << 8);
+        if (old_start != 0) old_broken = !get_chain(old_start, clusters);
+    } else {
+        entry = find_empty_entry();
+    }
+    if (!entry || exhausted_) return false;
+
+    size_t needed = (size_t(file_size) + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    if (old_broken) {
+        // The walk may end on a free or bad cluster, which free_chain() leaves
+        // alone; free the rest and start over on fresh clusters. An
+        // out-of-range start walks nothing and leaves nothing to free.
+        if (!clusters.empty()) {
+            uint16_t last = get_fat_entry(clusters.back());
+            if (last == 0x000 || last == 0xFF7) clusters.pop_back();
         }
+        if (exhausted_ || free_clusters() + clusters.size() < needed) return false;
+        if (!clusters.empty()) free_chain(old_start);
+        clusters.clear();
     }
-    if (entry_sector == -1) return false;
 
-    uint16_t first_cluster = find_free_cluster();
-    uint16_t current_cluster = first_cluster;
-    uint32_t bytes_remaining = file_size, buf_pos = 0;
+    // Collect every extra cluster in one scan (first fit, ascending) before
+    // touching the FAT, so a full disk fails cleanly
+    if (needed > clusters.size()) {
+        if (free_clusters() < needed - clusters.size()) return false;
+        STE_TIME(free_scan_ns);
+        STE_COUNT(free_cluster_scans, 1);
+        const uint16_t limit = cluster_limit();
+        for (uint16_t c = 2; c < limit && clusters.size() < needed; ++c) {
+            STE_COUNT(free_cluster_probes, 1);
+            if (get_fat_entry(c) == 0x000) clusters.push_back(c);
+        }
+        if (clusters.size() < needed || exhausted_) return false;
+    }
+    for (size_t n = needed; n < clusters.size(); ++n) set_fat_entry(clusters[n], 0x000);
+    clusters.resize(needed);
 
-    while (bytes_remaining > 0) {
-        set_fat_entry(current_cluster, 0xFFF);
+    uint32_t bytes_remaining = file_size, buf_pos = 0;
+    for (size_t n = 0; n < clusters.size(); ++n) {
+        set_fat_entry(clusters[n], n + 1 < clusters.size() ? clusters[n + 1] : 0xFFF);
         for (int i = 0; i < 2 && bytes_remaining > 0; ++i) {
-            auto sector = disk_.get_sector(18 + (current_cluster - 2) * 2 + i);
+            auto sector = disk_.get_sector(cluster_sector(clusters[n]) + i);
             uint32_t to_write = std::min((uint32_t)512, bytes_remaining);
             std::memcpy(sector.data(), &buffer[buf_pos], to_write);
+            STE_COUNT(file_bytes_written, to_write);
             buf_pos += to_write; bytes_remaining -= to_write;
         }
-        if (bytes_remaining > 0) {
-            uint16_t next = find_free_cluster();
-            set_fat_entry(current_cluster, next);
-            current_cluster = next;
-        }
     }
+    uint16_t first_cluster = clusters.empty() ? 0 : clusters[0];
 
-    auto root_sector = disk_.get_sector(entry_sector);
-    uint8_t* entry = &root_sector[entry_offset];
-    std::memset(entry, 0x20, 11);
-    size_t dot = target_name.find('.');
-    std::string base = target_name.substr(0, dot);
-    std::string ext = (dot != std::string::npos) ? target_name.substr(dot + 1) : "";
-    std::memcpy(entry, base.c_str(), std::min((size_t)8, base.length()));
-    std::memcpy(entry + 8, ext.c_str(), std::min((size_t)3, ext.length()));
-    entry[11] = 0x00;
+    std::memset(entry, 0x00, 32);
+    encode_name(name, entry);
     entry[26] = first_cluster & 0xFF; entry[27] = (first_cluster >> 8) & 0xFF;
     entry[28] = file_size & 0xFF; entry[29] = (file_size >> 8) & 0xFF;
     entry[30] = (file_size >> 16) & 0xFF; entry[31] = (file_size >> 24) & 0xFF;
     return true;
 }
 
+void Fat12Driver::format() {
+    auto sector = disk_.get_sector(0);
+    if (sector.empty()) return;
+
+    // Standard 720KB (Double Sided, 9 Sectors, 80 Tracks) BPB
+    sector[0x0B] = 0x00; sector[0x0C] = 0x02; // Sector size: 512
+    sector[0x0D] = 0x02;                   // Sectors per cluster: 2
+    sector[0x0E] = 0x01; sector[0x0F] = 0x00; // Reserved sectors: 1
+    sector[0x10] = 0x02;                   // Number of FATs: 2
+    sector[0x11] = 0x70; sector[0x12] = 0x00; // Max directory entries: 112
+    sector[0x13] = 0xA0; sector[0x14] = 0x05; // Total sectors: 1440
+    sector[0x15] = 0xF9;                   // Media descriptor: 3.5" DS
+    sector[0x16] = 0x05; sector[0x17] = 0x00; // Sectors per FAT: 5
+    sector[0x18] = 0x09; sector[0x19] = 0x00; // Sectors per track: 9
+    sector[0x1A] = 0x02; sector[0x1B] = 0x00; // Number of sides: 2
+
+    // Empty FATs (media byte, then two reserved entries) and an empty root
+    // directory; only the data area keeps the 0xE5 format filler
+    for (size_t s = FAT_START; s < DATA_START; ++s) {
+        auto fs_sector = disk_.get_sector(s);
+        std::fill(fs_sector.begin(), fs_sector.end(), 0);
+    }
+    for (size_t copy = 0; copy < FAT_COPIES; ++copy) {
+        auto fat = disk_.get_sector(FAT_START + copy * FAT_SECTORS);
+        if (fat.empty()) break;
+        fat[0] = 0xF9; fat[1] = 0xFF; fat[2] = 0xFF;
+    }
+    free_known_ = false;
+    dirty_begin_ = SIZE_MAX;
+    dirty_end_ = 0;
+}
+
+uint8_t* Fat12Driver::find_entry(const std::string& filename_on_disk) {
+    uint8_t wanted[11];
+    encode_name(filename_on_disk, wanted);
+    STE_COUNT(dir_scans, 1);
+    for (size_t s = ROOT_DIR_START; s < ROOT_DIR_START + ROOT_DIR_SECTORS; ++s) {
+        auto sector = disk_.get_sector(s);
+        if (sector.empty()) continue;
+        for (int i = 0; i < 512; i += 32) {
+            STE_COUNT(dir_entries, 1);
+            if (!spend(1)) return nullptr;
+            if (sector[i] == 0x00) return nullptr;
+            if (sector[i] == 0xE5 || (sector[i+11] & 0x08)) continue;
+            if (std::memcmp(&sector[i], wanted, 11) == 0) return &sector[i];
+        }
+    }
+    return nullptr;
+}
+
+uint8_t* Fat12Driver::find_empty_entry() {
+    STE_COUNT(dir_scans, 1);
+    for (size_t s = ROOT_DIR_START; s < ROOT_DIR_START + ROOT_DIR_SECTORS; ++s) {
+        auto sector = disk_.get_sector(s);
+        if (sector.empty()) continue;
+        for (int i = 0; i < 512; i += 32) {
+            STE_COUNT(dir_entries, 1);
+            if (!spend(1)) return nullptr;
+            if (sector[i] == 0x00 || sector[i] == 0xE5) return &sector[i];
+        }
+    }
+    return nullptr;
+}
+
+bool Fat12Driver::delete_file(const std::string& filename_on_disk) {
+    std::string name;
+    if (!to_83(filename_on_disk, name)) return false;
+    uint8_t* entry = find_entry(name);
+    if (!entry || (entry[11] & 0x10)) return false;
+    free_chain(entry[26] | (entry[27] << 8));
+    entry[0] = 0xE5;
+    return !exhausted_;
+}
+
+bool Fat12Driver::rename_file(const std::string& filename_on_disk, const std::string& new_name) {
+    std::string old_name, name;
+    if (!to_83(filename_on_disk, old_name) || !to_83(new_name, name)) return false;
+    uint8_t* entry = find_entry(old_name);
+    if (!entry) return false;
+    uint8_t* clash = find_entry(name);
+    if (exhausted_ || (clash && clash != entry)) return false;
+    encode_name(name, entry);
+    return true;
+}
+
+bool Fat12Driver::truncate_file(const std::string& filename_on_disk, uint32_t new_size) {
+    std::string name;
+    if (!to_83(filename_on_disk, name)) return false;
+    uint8_t* entry = find_entry(name);
+    if (!entry || (entry[11] & 0x10)) return false;
+    uint32_t size = entry[28] | (entry[29] << 8) | (entry[30] << 16) | (uint32_t(entry[31]) << 24);
+    if (new_size > size) return false;
+
+    uint16_t start = entry[26] | (entry[27] << 8);
+    size_t keep = (size_t(new_size) + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    if (keep == 0) {
+        free_chain(start);
+        start = 0;
+    } else {
+        std::vector<uint16_t> chain;
+        if (!get_chain(start, chain, keep)) return false;
+        uint16_t next = get_fat_entry(chain.back());
+        set_fat_entry(chain.back(), 0xFFF);
+        if (next < 0xFF0) free_chain(next);
+    }
+    if (exhausted_) return false;
+    entry[26] = start & 0xFF; entry[27] = (start >> 8) & 0xFF;
+    entry[28] = new_size & 0xFF; entry[29] = (new_size >> 8) & 0xFF;
+    entry[30] = (new_size >> 16) & 0xFF; entry[31] = (new_size >> 24) & 0xFF;
+    return true;
+}
+
 } // namespace libste
@@ -0,0 +1,303 @@
+#include "FsCheck.hpp"
+#include "Fat12Driver.hpp"
+#include <deque>
+#include <cstdio>
+
+namespace libste {
+
+namespace {
+
+constexpr uint16_t kEndOfChain = 0xFFF;
+constexpr uint16_t kBadCluster = 0xFF7;
+constexpr size_t kEntrySize = 32;
+
+uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+void put_le16(uint8_t* p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+void put_le32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; ++i) p[i] = (v >> (i * 8)) & 0xFF; }
+
+uint16_t fat_entry_at(const uint8_t* fat, uint16_t cluster) {
+    size_t offset = (cluster * 3) / 2;
+    if (cluster % 2 == 0) return fat[offset] | ((fat[offset + 1] & 0x0F) << 8);
+    return (fat[offset] >> 4) | (fat[offset + 1] << 4);
+}
+
+std::string hex3(uint16_t v) {
+    char buf[8];
+    std::snprintf(buf, sizeof(buf), "0x%03X", v);
+    return buf;
+}
+
+std::string entry_name(const uint8_t* e) {
+    std::string name(reinterpret_cast<const char*>(e), 8);
+    std::string ext(reinterpret_cast<const char*>(e + 8), 3);
+    name.erase(name.find_last_not_of(' ') + 1);
+    ext.erase(ext.find_last_not_of(' ') + 1);
+    return ext.empty() ? name : name + "." + ext;
+}
+
+struct Directory {
+    std::string path;
+    std::vector<size_t> sectors;
+};
+
+class Checker {
+public:
+    Checker(DiskHandler& disk, bool repair) : disk_(disk), fat_(disk), repair_(repair) {}
+
+    FsCheckReport run() {
+        report_.boot_checksum_ok = disk_.verify_tos_checksum();
+        size_t sectors = disk_.get_total_size() / DiskHandler::SECTOR_SIZE;
+        if (sectors <= Fat12Driver::DATA_START) {
+            problem(FsProblemKind::ImageTooSmall, "", 0,
+                    std::to_string(sectors) + " sectors, the FAT12 layout needs more than " +
+                    std::to_string(Fat12Driver::DATA_START));
+            return report_;
+        }
+        limit_ = fat_.cluster_limit();
+        owner_.assign(limit_, -1);
+
+        check_media();
+        compare_fat_copies();
+
+        Directory root;
+        for (size_t i = 0; i < Fat12Driver::ROOT_DIR_SECTORS; ++i) root.sectors.push_back(Fat12Driver::ROOT_DIR_START + i);
+        pending_.push_back(std::move(root));
+        while (!pending_.empty()) {
+            Directory dir = std::move(pending_.front());
+            pending_.pop_front();
+            scan_directory(dir);
+        }
+
+        find_lost_clusters();
+        for (uint16_t c = 2; c < limit_; ++c) {
+            uint16_t v = fat_.get_fat_entry(c);
+            if (owner_[c] != -1) ++report_.used_clusters;
+            else if (v == 0) ++report_.free_clusters;
+            else if (v == kBadCluster) ++report_.bad_clusters;
+        }
+        if (repair_) fat_.sync_fat_copies();
+        return report_;
+    }
+
+private:
+    DiskHandler& disk_;
+    Fat12Driver fat_;
+    bool repair_;
+    FsCheckReport report_;
+    uint16_t limit_ = 2;
+    std::vector<int32_t> owner_;     // Cluster -> index into paths_, -1 = unowned
+    std::vector<std::string> paths_;
+    std::deque<Directory> pending_;
+
+    void problem(FsProblemKind kind, const std::string& path, uint16_t cluster, std::string message) {
+        report_.problems.push_back({ kind, path, cluster, std::move(message) });
+    }
+
+    std::string fixed(const char* what) const { return repair_ ? std::string("; ") + what : std::string(); }
+
+    uint8_t* fat_copy(size_t copy) {
+        return disk_.get_sectors(Fat12Driver::FAT_START + copy * Fat12Driver::FAT_SECTORS, Fat12Driver::FAT_SECTORS)
+            .data();
+    }
+
+    void check_media() {
+        uint8_t media = disk_.get_sector(0)[0x15];
+        if (media < 0xF0) media = 0xF9;  // No usable BPB: assume 3.5" DS
+        uint8_t* fat = fat_copy(0);
+        if (fat[0] == media && fat[1] == 0xFF && fat[2] == 0xFF) return;
+        problem(FsProblemKind::MediaDescriptor, "", 0, "FAT starts " + hex3(fat[0]) + ", BPB media is " + hex3(media) +
+                fixed("rewritten"));
+        if (repair_) {
+            fat[0] = media;
+            fat[1] = fat[2] = 0xFF;
+        }
+    }
+
+    void compare_fat_copies() {
+        const uint8_t* first = fat_copy(0);
+        for (size_t copy = 1; copy < Fat12Driver::FAT_COPIES; ++copy) {
+            const uint8_t* other = fat_copy(copy);
+            size_t differing = 0;
+            uint16_t first_diff = 0;
+            for (uint16_t c = 0; c < limit_; ++c) {
+                if (fat_entry_at(first, c) != fat_entry_at(other, c)) {
+                    if (differing++ == 0) first_diff = c;
+                }
+            }
+            if (differing == 0) continue;
+            problem(FsProblemKind::FatCopyMismatch, "", first_diff,
+                    "FAT #" + std::to_string(copy + 1) + " differs from FAT #1 in " + std::to_string(differing) +
+                    " entries" + fixed("rewritten from FAT #1"));
+        }
+    }
+
+    void scan_directory(const Directory& dir) {
+        for (size_t s : dir.sectors) {
+            auto sector = disk_.get_sector(s);
+            if (sector.empty()) continue;
+            for (size_t off = 0; off < sector.size(); off += kEntrySize) {
+                uint8_t* e = &sector[off];
+                if (e[0] == 0x00) return;
+                if (e[0] == 0xE5 || e[0] == '.' || (e[11] & 0x08)) continue;  // Free, . / .., label or VFAT name
+                check_entry(dir, e);
+            }
+        }
+    }
+
+    void check_entry(const Directory& dir, uint8_t* e) {
+        const bool is_dir = e[11] & 0x10;
+        std::string path = dir.path.empty() ? entry_name(e) : dir.path + "\\" + entry_name(e);
+        int32_t id = static_cast<int32_t>(paths_.size());
+        paths_.push_back(path);
+        is_dir ? ++report_.directories : ++report_.files;
+
+        uint16_t start = le16(e + 26);
+        uint32_t size = le32(e + 28);
+        if (start == 0 && !is_dir) {
+            if (size != 0) {
+                problem(FsProblemKind::SizeMismatch, path, 0, std::to_string(size) + " bytes but no clusters" +
+                        fixed("size set to 0"));
+                if (repair_) put_le32(e + 28, 0);
+            }
+            return;
+        }
+        if (start < 2 || start >= limit_) {
+            problem(FsProblemKind::BadStartCluster, path, start, "starts at cluster " + hex3(start) +
+                    (is_dir ? fixed("entry removed") : fixed("emptied")));
+            if (repair_) {
+                if (is_dir) {
+                    e[0] = 0xE5;
+                } else {
+                    put_le16(e + 26, 0);
+                    put_le32(e + 28, 0);
+                }
+            }
+            return;
+        }
+
+        std::vector<uint16_t> chain = walk(id, path, start, e);
+        if (is_dir) {
+            Directory sub{ path, {} };
+            for (uint16_t c : chain) {
+                for (size_t i = 0; i < Fat12Driver::SECTORS_PER_CLUSTER; ++i) sub.sectors.push_back(Fat12Driver::cluster_sector(c) + i);
+            }
+            pending_.push_back(std::move(sub));
+            return;
+        }
+
+        size_t needed = (size_t(size) + Fat12Driver::CLUSTER_SIZE - 1) / Fat12Driver::CLUSTER_SIZE;
+        if (chain.size() > needed) {
+            problem(FsProblemKind::SizeMismatch, path, chain[needed],
+                    std::to_string(chain.size()) + " clusters hold " + std::to_string(size) + " bytes" +
+                    fixed("surplus clusters freed"));
+            if (repair_) {
+                if (needed == 0) put_le16(e + 26, 0);
+                else fat_.set_fat_entry(chain[needed - 1], kEndOfChain);
+                for (size_t i = needed; i < chain.size(); ++i) {
+                    fat_.set_fat_entry(chain[i], 0);
+                    owner_[chain[i]] = -1;
+                }
+            }
+        } else if (chain.size() < needed) {
+            uint32_t bytes = static_cast<uint32_t>(chain.size() * Fat12Driver::CLUSTER_SIZE);
+            problem(FsProblemKind::SizeMismatch, path, 0,
+                    std::to_string(size) + " bytes but only " + std::to_string(chain.size()) + " clusters" +
+                    (repair_ ? "; size cut to " + std::to_string(bytes) : std::string()));
+            if (repair_) put_le32(e + 28, bytes);
+        }
+    }
+
+    // Claims every cluster of the chain for `id`. Each cluster is claimed once
+    // over the whole check, so running into an owned one is a loop or a cross-link.
+    std::vector<uint16_t> walk(int32_t id, const std::string& path, uint16_t start, uint8_t* e) {
+        std::vector<uint16_t> chain;
+        uint16_t c = start;
+        while (true) {
+            if (owner_[c] != -1) {
+                if (owner_[c] == id) {
+                    problem(FsProblemKind::ChainLoop, path, c, "chain loops back to cluster " + hex3(c) +
+                            fixed("ended before it"));
+                } else {
+                    problem(FsProblemKind::CrossLinked, path, c, "cluster " + hex3(c) + " also belongs to " +
+                            paths_[owner_[c]] + fixed("ended before it"));
+                }
+                if (repair_) end_chain(chain, e);
+                break;
+            }
+            owner_[c] = id;
+            chain.push_back(c);
+            uint16_t next = fat_.get_fat_entry(c);
+            if (next >= 0xFF8) break;
+            if (next < 2 || next >= limit_) {
+                problem(FsProblemKind::BrokenChain, path, c, "cluster " + hex3(c) + " links to " + hex3(next) +
+                        fixed("ended there"));
+                if (repair_) fat_.set_fat_entry(c, kEndOfChain);
+                break;
+            }
+            c = next;
+        }
+        return chain;
+    }
+
+    void end_chain(const std::vector<uint16_t>& chain, uint8_t* e) {
+        if (!chain.empty()) fat_.set_fat_entry(chain.back(), kEndOfChain);
+        else if (e[11] & 0x10) e[0] = 0xE5;  // A directory with no clusters left goes
+        else put_le16(e + 26, 0);
+    }
+
+    void find_lost_clusters() {
+        std::vector<bool> lost(limit_, false), linked(limit_, false);
+        uint16_t first = 0;
+        for (uint16_t c = 2; c < limit_; ++c) {
+            uint16_t v = fat_.get_fat_entry(c);
+            if (v != 0 && v != kBadCluster && owner_[c] == -1) {
+                lost[c] = true;
+                if (report_.lost_clusters++ == 0) first = c;
+            }
+        }
+        if (report_.lost_clusters == 0) return;
+
+        // Chains are counted by their heads: lost clusters no other lost cluster links to
+        for (uint16_t c = 2; c < limit_; ++c) {
+            uint16_t v = fat_.get_fat_entry(c);
+            if (lost[c] && v >= 2 && v < limit_ && lost[v]) linked[v] = true;
+        }
+        for (uint16_t c = 2; c < limit_; ++c) {
+            if (lost[c] && !linked[c]) ++report_.lost_chains;
+        }
+        if (report_.lost_chains == 0) report_.lost_chains = 1;  // Only loops left
+
+        problem(FsProblemKind::LostClusters, "", first,
+                std::to_string(report_.lost_clusters) + " clusters in " + std::to_string(report_.lost_chains) +
+                " chains belong to no file" + fixed("freed"));
+        if (repair_) {
+            for (uint16_t c = 2; c < limit_; ++c) {
+                if (lost[c]) fat_.set_fat_entry(c, 0);
+            }
+        }
+    }
+};
+
+} // namespace
+
+const char* to_string(FsProblemKind kind) {
+    switch (kind) {
+        case FsProblemKind::ImageTooSmall: return "image too small";
+        case FsProblemKind::MediaDescriptor: return "media descriptor";
+        case FsProblemKind::FatCopyMismatch: return "FAT copies differ";
+        case FsProblemKind::BadStartCluster: return "bad start cluster";
+        case FsProblemKind::BrokenChain: return "broken chain";
+        case FsProblemKind::ChainLoop: return "chain loop";
+        case FsProblemKind::CrossLinked: return "cross-linked";
+        case FsProblemKind::SizeMismatch: return "size mismatch";
+        case FsProblemKind::LostClusters: return "lost clusters";
+    }
+    return "?";
+}
+
+FsCheckReport check_filesystem(DiskHandler& disk, bool repair) {
+    return Checker(disk, repair).run();
+}
+
+} // namespace libste
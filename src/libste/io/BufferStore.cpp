@@ -0,0 +1,152 @@
+#include "BufferStore.hpp"
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <cstring>
+#include <unordered_map>
+
+namespace libste {
+
+namespace {
+
+// Node-based, so a buffer stays put while other buffers are added
+std::unordered_map<std::string, std::vector<uint8_t>>& buffers() {
+    static std::unordered_map<std::string, std::vector<uint8_t>> store;
+    return store;
+}
+
+std::streambuf::pos_type resolve_seek(std::streambuf::off_type off, std::ios_base::seekdir dir,
+                                      size_t cur, size_t end) {
+    std::streambuf::off_type base = dir == std::ios_base::beg ? 0 : dir == std::ios_base::cur ? cur : end;
+    std::streambuf::off_type pos = base + off;
+    return pos < 0 ? std::streambuf::pos_type(-1) : std::streambuf::pos_type(pos);
+}
+
+// Reads straight out of a buffer, no copy
+class SpanInBuf : public std::streambuf {
+public:
+    explicit SpanInBuf(std::span<const uint8_t> data) {
+        char* p = const_cast<char*>(reinterpret_cast<const char*>(data.data()));
+        setg(p, p, p + data.size());
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override {
+        pos_type pos = resolve_seek(off, dir, gptr() - eback(), egptr() - eback());
+        if (pos == pos_type(-1) || off_type(pos) > egptr() - eback()) return pos_type(-1);
+        setg(eback(), eback() + off_type(pos), egptr());
+        return pos;
+    }
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+// Writes into a buffer; seeking back overwrites (for headers patched on close)
+class VectorOutBuf : public std::streambuf {
+public:
+    explicit VectorOutBuf(std::vector<uint8_t>& data) : data_(data) {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+        char ch = traits_type::to_char_type(c);
+        xsputn(&ch, 1);
+        return c;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (pos_ + n > data_.size()) data_.resize(pos_ + n);
+        std::memcpy(data_.data() + pos_, s, static_cast<size_t>(n));
+        pos_ += static_cast<size_t>(n);
+        return n;
+    }
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override {
+        pos_type pos = resolve_seek(off, dir, pos_, data_.size());
+        if (pos != pos_type(-1)) pos_ = static_cast<size_t>(off_type(pos));
+        return pos;
+    }
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+private:
+    std::vector<uint8_t>& data_;
+    size_t pos_ = 0;
+};
+
+class BufferInStream : public std::istream {
+public:
+    explicit BufferInStream(std::span<const uint8_t> data) : std::istream(nullptr), buf_(data) { rdbuf(&buf_); }
+
+private:
+    SpanInBuf buf_;
+};
+
+class BufferOutStream : public std::ostream {
+public:
+    explicit BufferOutStream(std::vector<uint8_t>& data) : std::ostream(nullptr), buf_(data) { rdbuf(&buf_); }
+
+private:
+    VectorOutBuf buf_;
+};
+
+} // namespace
+
+bool is_buffer_path(std::string_view path) {
+    return path.size() > 1 && path[0] == '@';
+}
+
+bool load_input(const std::string& path, std::vector<uint8_t>& storage, std::span<const uint8_t>& data) {
+    if (is_buffer_path(path)) {
+        auto it = buffers().find(path);
+        if (it == buffers().end()) return false;
+        data = it->second;
+        return true;
+    }
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    if (!ifs) return false;
+    storage.resize(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0, std::ios::beg);
+    if (!ifs.read(reinterpret_cast<char*>(storage.data()), storage.size())) return false;
+    data = storage;
+    return true;
+}
+
+bool save_output(const std::string& path, std::span<const uint8_t> data) {
+    if (is_buffer_path(path)) {
+        buffers()[path].assign(data.begin(), data.end());
+        return true;
+    }
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs) return false;
+    ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return ofs.good();
+}
+
+std::unique_ptr<std::istream> open_input_stream(const std::string& path) {
+    if (is_buffer_path(path)) {
+        auto it = buffers().find(path);
+        if (it == buffers().end()) return nullptr;
+        return std::make_unique<BufferInStream>(it->second);
+    }
+    auto ifs = std::make_unique<std::ifstream>(path, std::ios::binary);
+    if (!*ifs) return nullptr;
+    return ifs;
+}
+
+std::unique_ptr<std::ostream> open_output_stream(const std::string& path) {
+    if (is_buffer_path(path)) {
+        auto& data = buffers()[path];
+        data.clear();
+        return std::make_unique<BufferOutStream>(data);
+    }
+    auto ofs = std::make_unique<std::ofstream>(path, std::ios::binary | std::ios::trunc);
+    if (!*ofs) return nullptr;
+    return ofs;
+}
+
+void clear_buffers() {
+    buffers().clear();
+}
+
+} // namespace libste
@@ -0,0 +1,320 @@
+#include "Lha.hpp"
+#include <cstring>
+
+namespace libste {
+
+namespace {
+
+// -lh5- parameters (8 KB dictionary)
+constexpr int DICBIT = 13;
+constexpr int MAXMATCH = 256;
+constexpr int THRESHOLD = 3;
+constexpr int NC = 255 + MAXMATCH + 2 - THRESHOLD;  // Literal/length alphabet
+constexpr int CBIT = 9;
+constexpr int NP = DICBIT + 1;                       // Position alphabet
+constexpr int PBIT = 4;
+constexpr int NT = 16 + 3;                           // Code-length alphabet
+constexpr int TBIT = 5;
+constexpr int NPT = NT > NP ? NT : NP;
+
+// No .YM dump comes near this; a larger header size is not worth allocating for
+constexpr uint32_t kMaxOriginalSize = 64 * 1024 * 1024;
+
+uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+
+// Static Huffman decoder for one -lh5- stream
+class Lh5Decoder {
+public:
+    explicit Lh5Decoder(std::span<const uint8_t> in) : in_(in) { fill(16); }
+
+    bool decode(std::vector<uint8_t>& out, size_t original_size) {
+        out.clear();
+        out.reserve(original_size);
+        while (out.size() < original_size) {
+            // The bit buffer looks a few bytes ahead; anything more means truncated or hostile input
+            if (overrun_ > 4) return false;
+            int c = decode_c();
+            if (c < 0) return false;
+            if (c <= 0xFF) {
+                out.push_back(static_cast<uint8_t>(c));
+            } else {
+                int length = c - 0x100 + THRESHOLD;
+                int p = decode_p();
+                if (p < 0) return false;
+                size_t distance = size_t(p) + 1;
+                if (distance > out.size()) return false;
+                size_t from = out.size() - distance;
+                for (int i = 0; i < length && out.size() < original_size; ++i) {
+                    out.push_back(out[from + i]);
+                }
+            }
+        }
+        return !error_;
+    }
+
+private:
+    std::span<const uint8_t> in_;
+    size_t in_pos_ = 0;
+    uint16_t bitbuf_ = 0;
+    uint8_t subbitbuf_ = 0;
+    int bitcount_ = 0;
+    bool error_ = false;
+    size_t overrun_ = 0;  // Zero bytes fed past the end of the input
+
+    uint16_t blocksize_ = 0;
+    uint8_t c_len_[NC];
+    uint8_t pt_len_[NPT];
+    uint16_t c_table_[4096];
+    uint16_t pt_table_[256];
+    uint16_t left_[2 * NC - 1];
+    uint16_t right_[2 * NC - 1];
+
+    void fill(int n) {
+        bitbuf_ = static_cast<uint16_t>(bitbuf_ << n);
+        while (n > bitcount_) {
+            n -= bitcount_;
+            bitbuf_ |= static_cast<uint16_t>(subbitbuf_ << n);
+            if (in_pos_ < in_.size()) {
+                subbitbuf_ = in_[in_pos_++];
+            } else {
+                subbitbuf_ = 0;
+                ++overrun_;
+            }
+            bitcount_ = 8;
+        }
+        bitcount_ -= n;
+        bitbuf_ |= static_cast<uint16_t>(subbitbuf_ >> bitcount_);
+    }
+
+    uint16_t get(int n) {
+        if (n == 0) return 0;
+        uint16_t x = static_cast<uint16_t>(bitbuf_ >> (16 - n));
+        fill(n);
+        return x;
+    }
+
+    bool make_table(int nchar, const uint8_t* bitlen, int tablebits, uint16_t* table) {
+        uint32_t count[17] = {}, weight[17], start[18];
+        for (int i = 0; i < nchar; ++i) {
+            if (bitlen[i] > 16) return false;
+            count[bitlen[i]]++;
+        }
+
+        start[1] = 0;
+        for (int i = 1; i <= 16; ++i) start[i + 1] = start[i] + (count[i] << (16 - i));
+        if (start[17] != (1u << 16)) return false;  // Incomplete or oversubscribed code
+
+        int jutbits = 16 - tablebits;
+        for (int i = 1; i <= tablebits; ++i) {
+            start[i] >>= jutbits;
+            weight[i] = 1u << (tablebits - i);
+        }
+        for (int i = tablebits + 1; i <= 16; ++i) weight[i] = 1u << (16 - i);
+
+        uint32_t i = start[tablebits + 1] >> jutbits;
+        uint32_t k = 1u << tablebits;
+        if (i != ((1u << 16) >> jutbits)) {
+            while (i != k) table[i++] = 0;
+        }
+
+        int avail = nchar;
+        uint32_t mask = 1u << (15 - tablebits);
+        for (int ch = 0; ch < nchar; ++ch) {
+            int len = bitlen[ch];
+            if (len == 0) continue;
+            uint32_t nextcode = start[len] + weight[len];
+            if (len <= tablebits) {
+                if (nextcode > k) return false;
+                for (uint32_t j = start[len]; j < nextcode; ++j) table[j] = static_cast<uint16_t>(ch);
+            } else {
+                uint32_t code = start[len];
+                uint16_t* p = &table[code >> jutbits];
+                for (int n = len - tablebits; n > 0; --n) {
+                    if (*p == 0) {
+                        if (avail >= 2 * NC - 1) return false;
+                        right_[avail] = left_[avail] = 0;
+                        *p = static_cast<uint16_t>(avail++);
+                    }
+                    p = (code & mask) ? &right_[*p] : &left_[*p];
+                    code = (code << 1) & 0xFFFF;
+                }
+                *p = static_cast<uint16_t>(ch);
+            }
+            start[len] = nextcode;
+        }
+        return true;
+    }
+
+    bool read_pt_len(int nn, int nbit, int i_special) {
+        int n = get(nbit);
+        if (n == 0) {
+            uint16_t c = get(nbit);
+            std::memset(pt_len_, 0, sizeof(pt_len_));
+            for (auto& t : pt_table_) t = c;
+            return c < nn;
+        }
+        if (n > nn) return false;
+
+        int i = 0;
+        while (i < n) {
+            int c = bitbuf_ >> 13;
+            if (c == 7) {
+                uint16_t mask = 1u << 12;
+                while (mask & bitbuf_) {
+                    mask >>= 1;
+                    ++c;
+                }
+                if (c > 16) return false;
+            }
+            fill(c < 7 ? 3 : c - 3);
+            pt_len_[i++] = static_cast<uint8_t>(c);
+            if (i == i_special) {
+                int zeros = get(2);
+                while (--zeros >= 0 && i < nn) pt_len_[i++] = 0;
+            }
+        }
+        while (i < nn) pt_len_[i++] = 0;
+        return make_table(nn, pt_len_, 8, pt_table_);
+    }
+
+    bool read_c_len() {
+        int n = get(CBIT);
+        if (n == 0) {
+            uint16_t c = get(CBIT);
+            std::memset(c_len_, 0, sizeof(c_len_));
+            for (auto& t : c_table_) t = c;
+            return c < NC;
+        }
+        if (n > NC) return false;
+
+        int i = 0;
+        while (i < n) {
+            int c = pt_table_[bitbuf_ >> 8];
+            if (c >= NT) {
+                uint16_t mask = 1u << 7;
+                do {
+                    c = (bitbuf_ & mask) ? right_[c] : left_[c];
+                    mask >>= 1;
+                } while (c >= NT && mask);
+                if (c >= NT) return false;
+            }
+            fill(pt_len_[c]);
+            if (c <= 2) {
+                if (c == 0) c = 1;
+                else if (c == 1) c = get(4) + 3;
+                else c = get(CBIT) + 20;
+                while (--c >= 0 && i < NC) c_len_[i++] = 0;
+            } else {
+                c_len_[i++] = static_cast<uint8_t>(c - 2);
+            }
+        }
+        while (i < NC) c_len_[i++] = 0;
+        return make_table(NC, c_len_, 12, c_table_);
+    }
+
+    int decode_c() {
+        if (blocksize_ == 0) {
+            blocksize_ = get(16);
+            if (blocksize_ == 0 || !read_pt_len(NT, TBIT, 3) || !read_c_len() || !read_pt_len(NP, PBIT, -1)) {
+                error_ = true;
+                return -1;
+            }
+        }
+        blocksize_--;
+        int j = c_table_[bitbuf_ >> 4];
+        if (j >= NC) {
+            uint16_t mask = 1u << 3;
+            do {
+                j = (bitbuf_ & mask) ? right_[j] : left_[j];
+                mask >>= 1;
+            } while (j >= NC && mask);
+            if (j >= NC) { error_ = true; return -1; }
+        }
+        fill(c_len_[j]);
+        return j;
+    }
+
+    int decode_p() {
+        int j = pt_table_[bitbuf_ >> 8];
+        if (j >= NP) {
+            uint16_t mask = 1u << 7;
+            do {
+                j = (bitbuf_ & mask) ? right_[j] : left_[j];
+                mask >>= 1;
+            } while (j >= NP && mask);
+            if (j >= NP) { error_ = true; return -1; }
+        }
+        fill(pt_len_[j]);
+        if (j != 0) j = (1 << (j - 1)) + get(j - 1);
+        return j;
+    }
+};
+
+} // namespace
+
+bool lha_read_header(std::span<const uint8_t> archive, LhaMember& member) {
+    if (archive.size() < 22) return false;
+    const uint8_t* h = archive.data();
+    int level = h[20];
+    member.method.assign(reinterpret_cast<const char*>(h + 2), 5);
+    if (member.method.size() != 5 || member.method[0] != '-' || member.method[4] != '-') return false;
+    member.packed_size = le32(h + 7);
+    member.original_size = le32(h + 11);
+
+    if (level == 0 || level == 1) {
+        size_t header_size = size_t(h[0]) + 2;
+        size_t name_len = h[21];
+        if (22 + name_len > archive.size() || header_size > archive.size()) return false;
+        member.filename.assign(reinterpret_cast<const char*>(h + 22), name_len);
+        member.data_offset = header_size;
+        if (level == 1) {
+            // Extended headers follow the base header and count towards packed_size
+            size_t next = le16(h + header_size - 2);
+            size_t pos = header_size;
+            while (next != 0) {
+                if (pos + next > archive.size() || next < 2) return false;
+                member.packed_size -= static_cast<uint32_t>(next);
+                pos += next;
+                next = le16(h + pos - 2);
+            }
+            member.data_offset = pos;
+        }
+    } else if (level == 2) {
+        size_t header_size = le16(h);
+        if (header_size > archive.size() || header_size < 26) return false;
+        member.data_offset = header_size;
+        // Filename lives in an extended header (type 0x01)
+        size_t pos = 24;
+        size_t next = le16(h + pos);
+        pos += 2;
+        while (next != 0 && pos + next <= header_size) {
+            if (next < 3) return false;
+            if (h[pos] == 0x01) member.filename.assign(reinterpret_cast<const char*>(h + pos + 1), next - 3);
+            size_t following = le16(h + pos + next - 2);
+            pos += next;
+            next = following;
+        }
+    } else {
+        return false;
+    }
+    return member.data_offset + member.packed_size <= archive.size();
+}
+
+bool lha_depack(std::span<const uint8_t> archive, std::vector<uint8_t>& out) {
+    LhaMember member;
+    if (!lha_read_header(archive, member)) return false;
+    auto data = archive.subspan(member.data_offset, member.packed_size);
+
+    if (member.method == "-lh0-") {
+        if (member.packed_size != member.original_size) return false;
+        out.assign(data.begin(), data.end());
+        return true;
+    }
+    if (member.method != "-lh5-" || member.original_size > kMaxOriginalSize) return false;
+
+    Lh5Decoder decoder(data);
+    return decoder.decode(out, member.original_size);
+}
+
+} // namespace libste
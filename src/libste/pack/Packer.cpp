@@ -0,0 +1,227 @@
+#include "Packer.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace libste {
+
+namespace {
+
+// LZ4 block constraints
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5;     // The block always ends with 5+ literals
+constexpr size_t kMatchStartLimit = 12; // No match may start in the last 12 bytes
+constexpr size_t kMaxOffset = 65535;
+
+constexpr int kHashBits = 16;
+constexpr size_t kWindowMask = 0xFFFF;
+constexpr int kMaxChain = 64;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+uint32_t hash4(uint32_t v) { return (v * 2654435761u) >> (32 - kHashBits); }
+
+class MatchFinder {
+public:
+    explicit MatchFinder(std::span<const uint8_t> in)
+        : in_(in), head_(size_t(1) << kHashBits, -1), prev_(kWindowMask + 1, -1) {}
+
+    void insert(size_t pos) {
+        uint32_t h = hash4(read32(&in_[pos]));
+        prev_[pos & kWindowMask] = head_[h];
+        head_[h] = static_cast<int32_t>(pos);
+    }
+
+    // Longest match for pos ending no later than `limit`; returns its length
+    size_t find(size_t pos, size_t limit, size_t& offset) const {
+        const uint8_t* p = &in_[pos];
+        const uint32_t first = read32(p);
+        size_t best = 0;
+        int32_t cand = head_[hash4(first)];
+        for (int depth = 0; depth < kMaxChain && cand >= 0; ++depth) {
+            size_t c = static_cast<size_t>(cand);
+            if (c >= pos || pos - c > kMaxOffset) break;
+            if (read32(&in_[c]) == first && in_[c + best] == p[best]) {
+                size_t len = kMinMatch;
+                while (pos + len < limit && in_[c + len] == p[len]) ++len;
+                if (len > best) {
+                    best = len;
+                    offset = pos - c;
+                    if (pos + len >= limit) break;
+                }
+            }
+            int32_t next = prev_[c & kWindowMask];
+            if (next >= cand) break;  // Slot reused by a newer position
+            cand = next;
+        }
+        return best >= kMinMatch ? best : 0;
+    }
+
+private:
+    std::span<const uint8_t> in_;
+    std::vector<int32_t> head_;
+    std::vector<int32_t> prev_;
+};
+
+void put_length(std::vector<uint8_t>& out, size_t len) {
+    while (len >= 255) {
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(len));
+}
+
+void put_sequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t lit_len, size_t offset, size_t match_len) {
+    size_t ml = match_len ? match_len - kMinMatch : 0;
+    uint8_t token = static_cast<uint8_t>((std::min<size_t>(lit_len, 15) << 4) | std::min<size_t>(ml, 15));
+    out.push_back(token);
+    if (lit_len >= 15) put_length(out, lit_len - 15);
+    out.insert(out.end(), literals, literals + lit_len);
+    if (match_len == 0) return;  // Final literal-only sequence
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (ml >= 15) put_length(out, ml - 15);
+}
+
+} // namespace
+
+void rle_pack(std::span<const uint8_t> in, std::vector<uint8_t>& out) {
+    out.clear();
+    size_t i = 0, n = in.size();
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < 128 && in[i + run] == in[i]) ++run;
+        if (run >= 3) {
+            out.push_back(static_cast<uint8_t>(257 - run));
+            out.push_back(in[i]);
+            i += run;
+            continue;
+        }
+        // Literal stretch up to the next run of three
+        size_t start = i;
+        while (i < n && i - start < 128) {
+            if (i + 2 < n && in[i] == in[i + 1] && in[i] == in[i + 2]) break;
+            ++i;
+        }
+        out.push_back(static_cast<uint8_t>(i - start - 1));
+        out.insert(out.end(), in.begin() + start, in.begin() + i);
+    }
+}
+
+bool rle_depack(std::span<const uint8_t> in, std::vector<uint8_t>& out, size_t original_size) {
+    out.clear();
+    out.reserve(original_size);
+    size_t i = 0;
+    while (i < in.size() && out.size() < original_size) {
+        uint8_t n = in[i++];
+        if (n < 128) {
+            size_t count = size_t(n) + 1;
+            if (i + count > in.size()) return false;
+            out.insert(out.end(), in.begin() + i, in.begin() + i + count);
+            i += count;
+        } else if (n > 128) {
+            if (i >= in.size()) return false;
+            out.insert(out.end(), 257 - n, in[i++]);
+        }
+    }
+    return out.size() == original_size;
+}
+
+void lz4_pack(std::span<const uint8_t> in, std::vector<uint8_t>& out) {
+    out.clear();
+    out.reserve(in.size() + in.size() / 255 + 16);
+    const size_t n = in.size();
+    size_t anchor = 0;
+
+    if (n > kMatchStartLimit) {
+        MatchFinder finder(in);
+        const size_t match_limit = n - kLastLiterals;
+        const size_t start_limit = n - kMatchStartLimit;
+        size_t pos = 0;
+        while (pos < start_limit) {
+            size_t offset = 0;
+            size_t len = finder.find(pos, match_limit, offset);
+            finder.insert(pos);
+            if (len == 0) {
+                ++pos;
+                continue;
+            }
+
+            // Lazy step: a longer match one byte later wins
+            if (pos + 1 < start_limit) {
+                size_t next_offset = 0;
+                size_t next_len = finder.find(pos + 1, match_limit, next_offset);
+                if (next_len > len + 1) {
+                    finder.insert(++pos);
+                    len = next_len;
+                    offset = next_offset;
+                }
+            }
+
+            put_sequence(out, &in[anchor], pos - anchor, offset, len);
+            size_t end = pos + len;
+            for (++pos; pos < end && pos < start_limit; ++pos) finder.insert(pos);
+            pos = anchor = end;
+        }
+    }
+    put_sequence(out, in.data() + anchor, n - anchor, 0, 0);
+}
+
+bool lz4_depack(std::span<const uint8_t> in, std::vector<uint8_t>& out, size_t original_size) {
+    out.clear();
+    out.reserve(original_size);
+    size_t i = 0;
+    auto get_length = [&](size_t len) -> size_t {
+        if (len != 15) return len;
+        uint8_t b;
+        do {
+            if (i >= in.size()) return SIZE_MAX;
+            b = in[i++];
+            len += b;
+        } while (b == 255);
+        return len;
+    };
+
+    while (i < in.size()) {
+        uint8_t token = in[i++];
+        size_t lit = get_length(token >> 4);
+        if (lit > in.size() - i || out.size() + lit > original_size) return false;
+        out.insert(out.end(), in.begin() + i, in.begin() + i + lit);
+        i += lit;
+        if (i == in.size()) break;  // Last sequence has no match
+
+        if (i + 2 > in.size()) return false;
+        size_t offset = in[i] | (in[i + 1] << 8);
+        i += 2;
+        size_t len = get_length(token & 0x0F);
+        if (len == SIZE_MAX || offset == 0 || offset > out.size()) return false;
+        len += kMinMatch;
+        if (out.size() + len > original_size) return false;
+        size_t from = out.size() - offset;
+        for (size_t k = 0; k < len; ++k) out.push_back(out[from + k]);
+    }
+    return out.size() == original_size;
+}
+
+void pack_data(std::span<const uint8_t> in, PackFormat format, std::vector<uint8_t>& out) {
+    switch (format) {
+        case PackFormat::Rle: rle_pack(in, out); break;
+        case PackFormat::Lz4: lz4_pack(in, out); break;
+        default: out.assign(in.begin(), in.end()); break;
+    }
+}
+
+bool depack_data(std::span<const uint8_t> in, PackFormat format, std::vector<uint8_t>& out, size_t original_size) {
+    switch (format) {
+        case PackFormat::Rle: return rle_depack(in, out, original_size);
+        case PackFormat::Lz4: return lz4_depack(in, out, original_size);
+        default:
+            out.assign(in.begin(), in.end());
+            return out.size() == original_size;
+    }
+}
+
+} // namespace libste
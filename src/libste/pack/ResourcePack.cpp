@@ -0,0 +1,81 @@
+#include "ResourcePack.hpp"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+
+namespace libste {
+
+namespace {
+
+std::string id_from_path(const std::string& prefix, const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string id = prefix + "_" + path.substr(slash == std::string::npos ? 0 : slash + 1);
+    for (auto& c : id) {
+        c = std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : '_';
+    }
+    return id;
+}
+
+} // namespace
+
+uint32_t asset_name_hash(std::string_view name) {
+    uint32_t h = 2166136261u;
+    for (char c : name) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool read_manifest(const std::string& path, const std::string& prefix, std::vector<ManifestItem>& items) {
+    std::ifstream ifs(path);
+    if (!ifs) return false;
+
+    items.clear();
+    std::unordered_set<std::string> ids;
+    std::string line;
+    while (std::getline(ifs, line)) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream fields(line);
+        ManifestItem item;
+        if (!(fields >> item.path)) continue;
+        if (!(fields >> item.id)) item.id = id_from_path(prefix, item.path);
+        if (!ids.insert(item.id).second) return false;
+        items.push_back(std::move(item));
+    }
+    return true;
+}
+
+bool add_pack_asset(ResourcePack& pack, const ManifestItem& item, std::span<const uint8_t> data,
+                    PackFormat format, size_t align) {
+    PackEntry entry;
+    entry.name = item.path;
+    entry.id = item.id;
+    entry.offset = static_cast<uint32_t>(pack.blob.size());
+    entry.size = static_cast<uint32_t>(data.size());
+    entry.name_hash = asset_name_hash(item.path);
+
+    std::vector<uint8_t> packed;
+    if (format != PackFormat::None) {
+        pack_data(data, format, packed);
+        std::vector<uint8_t> check;
+        if (!depack_data(packed, format, check, data.size()) || !std::equal(check.begin(), check.end(), data.begin(), data.end())) {
+            return false;
+        }
+    }
+    if (!packed.empty() && packed.size() < data.size()) {
+        entry.packed_size = static_cast<uint32_t>(packed.size());
+        pack.blob.insert(pack.blob.end(), packed.begin(), packed.end());
+    } else {
+        pack.blob.insert(pack.blob.end(), data.begin(), data.end());
+    }
+    if (align > 1) pack.blob.resize((pack.blob.size() + align - 1) / align * align, 0);
+
+    pack.entries.push_back(std::move(entry));
+    return true;
+}
+
+} // namespace libste
@@ -0,0 +1,192 @@
+#include "ColorMatcher.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <thread>
+
+namespace libste {
+
+namespace {
+
+// sRGB transfer curve, precomputed per 8-bit level
+const std::array<float, 256>& srgb_to_linear() {
+    static const std::array<float, 256> table = [] {
+        std::array<float, 256> t{};
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            t[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return t;
+    }();
+    return table;
+}
+
+float lab_f(float t) {
+    constexpr float delta = 6.0f / 29.0f;
+    return (t > delta * delta * delta) ? std::cbrt(t) : t / (3 * delta * delta) + 4.0f / 29.0f;
+}
+
+float axis(const Lab& p, int depth) {
+    switch (depth % 3) {
+        case 0: return p.l;
+        case 1: return p.a;
+        default: return p.b;
+    }
+}
+
+float distance2(const Lab& p, const Lab& q) {
+    float dl = p.l - q.l, da = p.a - q.a, db = p.b - q.b;
+    return dl * dl + da * da + db * db;
+}
+
+} // namespace
+
+Lab rgb_to_lab(Rgb8 c) {
+    const auto& lin = srgb_to_linear();
+    float r = lin[c.r], g = lin[c.g], b = lin[c.b];
+
+    // Linear sRGB -> XYZ, normalised to the D65 white point
+    float x = (0.4124564f * r + 0.3575761f * g + 0.1804375f * b) / 0.95047f;
+    float y = (0.2126729f * r + 0.7151522f * g + 0.0721750f * b);
+    float z = (0.0193339f * r + 0.1191920f * g + 0.9503041f * b) / 1.08883f;
+
+    float fx = lab_f(x), fy = lab_f(y), fz = lab_f(z);
+    return { 116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz) };
+}
+
+ColorMatcher::ColorMatcher() {
+    lab_.resize(4096);
+    tree_.resize(4096);
+    for (uint16_t w = 0; w < 4096; ++w) {
+        lab_[w] = rgb_to_lab(ste_word_to_rgb(w));
+        tree_[w] = { lab_[w], w };
+    }
+    build_tree(0, tree_.size(), 0);
+}
+
+void ColorMatcher::build_grid() const {
+    std::call_once(grid_once_, [this] {
+        // Exact answers on the cell corners (GRID_SIZE + 1 per axis)
+        constexpr int step = 256 / GRID_SIZE;
+        constexpr int corners = GRID_SIZE + 1;
+        std::vector<uint16_t> lattice(size_t(corners) * corners * corners);
+        auto fill_slices = [&](int r_begin, int r_end) {
+            for (int r = r_begin; r < r_end; ++r) {
+                size_t idx = size_t(r) * corners * corners;
+                for (int g = 0; g < corners; ++g) {
+                    for (int b = 0; b < corners; ++b) {
+                        Rgb8 c = { uint8_t(std::min(r * step, 255)), uint8_t(std::min(g * step, 255)), uint8_t(std::min(b * step, 255)) };
+                        lattice[idx++] = nearest_exact(c);
+                    }
+                }
+            }
+        };
+        // The lattice dominates construction time; split it across cores
+        int workers = std::clamp(int(std::thread::hardware_concurrency()), 1, 16);
+        std::vector<std::thread> pool;
+        for (int t = 1; t < workers; ++t) {
+            pool.emplace_back(fill_slices, corners * t / workers, corners * (t + 1) / workers);
+        }
+        fill_slices(0, corners / workers);
+        for (auto& th : pool) th.join();
+
+        grid_.resize(size_t(GRID_SIZE) * GRID_SIZE * GRID_SIZE);
+        size_t idx = 0;
+        for (int r = 0; r < GRID_SIZE; ++r) {
+            for (int g = 0; g < GRID_SIZE; ++g) {
+                for (int b = 0; b < GRID_SIZE; ++b) {
+                    uint16_t found[64];
+                    int count = 0;
+                    auto collect = [&](int lo, int hi) {
+                        for (int dr = lo; dr <= hi; ++dr) {
+                            for (int dg = lo; dg <= hi; ++dg) {
+                                for (int db = lo; db <= hi; ++db) {
+                                    int cr = r + dr, cg = g + dg, cb = b + db;
+                                    if (cr < 0 || cg < 0 || cb < 0 || cr >= corners || cg >= corners || cb >= corners) continue;
+                                    uint16_t w = lattice[(size_t(cr) * corners + cg) * corners + cb];
+                                    if (std::find(found, found + count, w) == found + count) found[count++] = w;
+                                }
+                            }
+                        }
+                    };
+                    collect(0, 1);
+                    // Boundary cell: widen the candidates to the neighbouring corners
+                    if (count > 1) collect(-1, 2);
+                    if (count == 1) {
+                        grid_[idx++] = found[0];
+                    } else {
+                        grid_[idx++] = AMBIGUOUS | (uint32_t(count) << 24) | uint32_t(candidates_.size());
+                        candidates_.insert(candidates_.end(), found, found + count);
+                    }
+                }
+            }
+        }
+        grid_ready_.store(true, std::memory_order_release);
+    });
+}
+
+const ColorMatcher& ColorMatcher::instance() {
+    static const ColorMatcher matcher;
+    return matcher;
+}
+
+void ColorMatcher::build_tree(size_t begin, size_t end, int depth) {
+    if (end - begin <= 1) return;
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(tree_.begin() + begin, tree_.begin() + mid, tree_.begin() + end,
+                     [depth](const Node& a, const Node& b) { return axis(a.lab, depth) < axis(b.lab, depth); });
+    build_tree(begin, mid, depth + 1);
+    build_tree(mid + 1, end, depth + 1);
+}
+
+void ColorMatcher::search(size_t begin, size_t end, int depth, const Lab& q, float& best_d, uint16_t& best) const {
+    if (begin >= end) return;
+    size_t mid = begin + (end - begin) / 2;
+    const Node& node = tree_[mid];
+
+    float d = distance2(node.lab, q);
+    if (d < best_d) { best_d = d; best = node.word; }
+
+    float diff = axis(q, depth) - axis(node.lab, depth);
+    bool left_first = diff < 0;
+    if (left_first) search(begin, mid, depth + 1, q, best_d, best);
+    else search(mid + 1, end, depth + 1, q, best_d, best);
+
+    // Only cross the splitting plane if it is closer than the current best
+    if (diff * diff < best_d) {
+        if (left_first) search(mid + 1, end, depth + 1, q, best_d, best);
+        else search(begin, mid, depth + 1, q, best_d, best);
+    }
+}
+
+uint16_t ColorMatcher::resolve(Rgb8 c, uint32_t cell) const {
+    Lab q = rgb_to_lab(c);
+    const uint16_t* cand = &candidates_[cell & 0x00FFFFFF];
+    int count = (cell >> 24) & 0x7F;
+    uint16_t best = cand[0];
+    float best_d = distance2(lab_[best], q);
+    for (int i = 1; i < count; ++i) {
+        float d = distance2(lab_[cand[i]], q);
+        if (d < best_d) { best_d = d; best = cand[i]; }
+    }
+    return best;
+}
+
+uint16_t ColorMatcher::nearest_exact(Rgb8 c) const {
+    Lab q = rgb_to_lab(c);
+    // Seed with the per-channel rounding so the tree walk prunes early
+    uint16_t best = rgb_to_ste_word(c);
+    float best_d = distance2(lab_[best], q);
+    search(0, tree_.size(), 0, q, best_d, best);
+    return best;
+}
+
+void ColorMatcher::remap(std::span<const Rgb8> pixels, std::span<uint16_t> out) const {
+    ensure_grid();
+    size_t n = std::min(pixels.size(), out.size());
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = lookup(pixels[i]);
+    }
+}
+
+} // namespace libste
@@ -0,0 +1,295 @@
+#include "Planar.hpp"
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <istream>
+#include <ostream>
+
+namespace libste {
+
+namespace {
+
+uint64_t load_le64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+// Gathers bit 0 of each of the 8 bytes in x into one byte, first byte in bit 7.
+inline uint8_t gather_bits(uint64_t x) {
+    return static_cast<uint8_t>(((x & 0x0101010101010101ULL) * 0x8040201008040201ULL) >> 56);
+}
+
+// 16 chunky pixels -> Planes words (Atari bits are high-to-low within the word)
+template <int Planes>
+inline void c2p_group(const uint8_t* px, uint16_t (&words)[Planes]) {
+    uint64_t lo = load_le64(px);
+    uint64_t hi = load_le64(px + 8);
+    for (int b = 0; b < Planes; ++b) {
+        words[b] = static_cast<uint16_t>((gather_bits(lo >> b) << 8) | gather_bits(hi >> b));
+    }
+}
+
+inline void store_be16(uint8_t* p, uint16_t w) {
+    p[0] = static_cast<uint8_t>(w >> 8);
+    p[1] = static_cast<uint8_t>(w);
+}
+
+template <int Planes, bool Interleaved>
+void c2p_kernel(std::span<const uint8_t> chunky, uint8_t* out, const PlaneLayout& layout, size_t rows) {
+    const size_t width = layout.width;
+    const size_t groups = layout.groups_per_row();
+    const size_t stride = layout.stride();
+    const size_t plane_size = stride * rows;
+    uint8_t tail[16];
+
+    for (size_t y = 0; y < rows; ++y) {
+        const uint8_t* row = chunky.data() + y * width;
+        size_t row_pixels = std::min(width, chunky.size() - y * width);
+        uint8_t* dst = out + y * stride;
+
+        for (size_t g = 0; g < groups; ++g) {
+            const uint8_t* px = row + g * 16;
+            if ((g + 1) * 16 > row_pixels) {
+                // Partial group at the end of a row: pad with colour 0
+                size_t n = row_pixels > g * 16 ? row_pixels - g * 16 : 0;
+                std::memset(tail, 0, sizeof(tail));
+                std::memcpy(tail, px, n);
+                px = tail;
+            }
+            uint16_t words[Planes];
+            c2p_group<Planes>(px, words);
+            for (int b = 0; b < Planes; ++b) {
+                if constexpr (Interleaved) store_be16(dst + (g * Planes + b) * 2, words[b]);
+                else store_be16(dst + b * plane_size + g * 2, words[b]);
+            }
+        }
+    }
+}
+
+// spread[b]: the 8 bits of b as 8 bytes holding 0/1, leftmost pixel (bit 7) in the low byte
+struct SpreadTable {
+    uint64_t v[256];
+    constexpr SpreadTable() : v() {
+        for (int b = 0; b < 256; ++b) {
+            for (int i = 0; i < 8; ++i) {
+                if (b & (0x80 >> i)) v[b] |= uint64_t(1) << (i * 8);
+            }
+        }
+    }
+};
+constexpr SpreadTable kSpread;
+
+inline void store_le64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (i * 8));
+}
+
+using KernelFn = void (*)(std::span<const uint8_t>, uint8_t*, const PlaneLayout&, size_t);
+
+template <int Planes>
+constexpr KernelFn pick(bool interleaved) {
+    return interleaved ? &c2p_kernel<Planes, true> : &c2p_kernel<Planes, false>;
+}
+
+template <int Planes, bool Interleaved>
+void p2c_kernel(const uint8_t* planar, uint8_t* chunky, const PlaneLayout& layout, size_t rows, size_t plane_size) {
+    const size_t width = layout.width;
+    const size_t groups = layout.groups_per_row();
+    const size_t stride = layout.stride();
+    uint8_t px[16];
+
+    for (size_t y = 0; y < rows; ++y) {
+        const uint8_t* src = planar + y * stride;
+        uint8_t* row = chunky + y * width;
+        for (size_t g = 0; g < groups; ++g) {
+            // Each plane adds one bit to 8 pixels per table lookup
+            uint64_t lo = 0, hi = 0;
+            for (int b = 0; b < Planes; ++b) {
+                const uint8_t* w = Interleaved ? src + (g * Planes + b) * 2 : src + b * plane_size + g * 2;
+                lo |= kSpread.v[w[0]] << b;
+                hi |= kSpread.v[w[1]] << b;
+            }
+            uint8_t* dst = (g + 1) * 16 <= width ? row + g * 16 : px;
+            store_le64(dst, lo);
+            store_le64(dst + 8, hi);
+            if (dst == px) std::memcpy(row + g * 16, px, width - g * 16);
+        }
+    }
+}
+
+using P2cFn = void (*)(const uint8_t*, uint8_t*, const PlaneLayout&, size_t, size_t);
+
+template <int Planes>
+constexpr P2cFn pick_p2c(bool interleaved) {
+    return interleaved ? &p2c_kernel<Planes, true> : &p2c_kernel<Planes, false>;
+}
+
+} // namespace
+
+bool chunky_to_planar(std::span<const uint8_t> chunky, std::span<uint8_t> planar, const PlaneLayout& layout) {
+    if (layout.planes < 1 || layout.planes > 8 || layout.width == 0) return false;
+    size_t min_stride = layout.groups_per_row() * 2 * (layout.interleaved ? layout.planes : 1);
+    if (layout.stride() < min_stride) return false;
+
+    size_t rows = (chunky.size() + layout.width - 1) / layout.width;
+    if (planar.size() < layout.planar_size(rows)) return false;
+    if (layout.row_stride) std::memset(planar.data(), 0, layout.planar_size(rows));
+
+    KernelFn kernel = nullptr;
+    switch (layout.planes) {
+        case 1: kernel = pick<1>(layout.interleaved); break;
+        case 2: kernel = pick<2>(layout.interleaved); break;
+        case 3: kernel = pick<3>(layout.interleaved); break;
+        case 4: kernel = pick<4>(layout.interleaved); break;
+        case 5: kernel = pick<5>(layout.interleaved); break;
+        case 6: kernel = pick<6>(layout.interleaved); break;
+        case 7: kernel = pick<7>(layout.interleaved); break;
+        case 8: kernel = pick<8>(layout.interleaved); break;
+    }
+    kernel(chunky, planar.data(), layout, rows);
+    return true;
+}
+
+bool chunky_to_planar(std::span<const uint8_t> chunky, std::vector<uint8_t>& planar, const PlaneLayout& layout) {
+    if (layout.width == 0) return false;
+    size_t rows = (chunky.size() + layout.width - 1) / layout.width;
+    planar.resize(layout.planar_size(rows));
+    return chunky_to_planar(chunky, std::span<uint8_t>(planar), layout);
+}
+
+bool planar_to_chunky(std::span<const uint8_t> planar, std::span<uint8_t> chunky, const PlaneLayout& layout) {
+    if (layout.planes < 1 || layout.planes > 8 || layout.width == 0) return false;
+    size_t min_stride = layout.groups_per_row() * 2 * (layout.interleaved ? layout.planes : 1);
+    if (layout.stride() < min_stride) return false;
+
+    size_t planar_rows = planar.size() / (layout.stride() * (layout.interleaved ? 1 : layout.planes));
+    size_t rows = std::min(chunky.size() / layout.width, planar_rows);
+
+    P2cFn kernel = nullptr;
+    switch (layout.planes) {
+        case 1: kernel = pick_p2c<1>(layout.interleaved); break;
+        case 2: kernel = pick_p2c<2>(layout.interleaved); break;
+        case 3: kernel = pick_p2c<3>(layout.interleaved); break;
+        case 4: kernel = pick_p2c<4>(layout.interleaved); break;
+        case 5: kernel = pick_p2c<5>(layout.interleaved); break;
+        case 6: kernel = pick_p2c<6>(layout.interleaved); break;
+        case 7: kernel = pick_p2c<7>(layout.interleaved); break;
+        case 8: kernel = pick_p2c<8>(layout.interleaved); break;
+    }
+    kernel(planar.data(), chunky.data(), layout, rows, layout.stride() * planar_rows);
+    return true;
+}
+
+bool stream_chunky_to_planar(std::istream& in, std::ostream& out, const PlaneLayout& layout, size_t block_rows,
+                             uint64_t& pixels_in, uint64_t& bytes_out) {
+    pixels_in = 0;
+    bytes_out = 0;
+    if (layout.width == 0 || block_rows == 0) return false;
+
+    const size_t block_pixels = layout.width * block_rows;
+    std::vector<uint8_t> chunky[2] = { std::vector<uint8_t>(block_pixels), std::vector<uint8_t>(block_pixels) };
+    std::vector<uint8_t> planar[2] = { std::vector<uint8_t>(layout.planar_size(block_rows)),
+                                       std::vector<uint8_t>(layout.planar_size(block_rows)) };
+    size_t filled[2] = { 0, 0 };
+    size_t produced[2] = { 0, 0 };
+
+    auto read_block = [&in](std::vector<uint8_t>& buf) {
+        return static_cast<size_t>(in.rdbuf()->sgetn(reinterpret_cast<char*>(buf.data()), buf.size()));
+    };
+    auto write_block = [&out](const std::vector<uint8_t>& buf, size_t n) {
+        return static_cast<size_t>(out.rdbuf()->sputn(reinterpret_cast<const char*>(buf.data()), n)) == n;
+    };
+
+    filled[0] = read_block(chunky[0]);
+    bool write_ok = true;
+    int pending_write = -1;
+
+    for (int cur = 0; filled[cur] > 0; cur ^= 1) {
+        int next = cur ^ 1;
+
+        // Overlap: read the next block (and flush the previous one) while converting this one
+        auto io = std::async(std::launch::async, [&, next, pending_write] {
+            if (pending_write >= 0) write_ok = write_ok && write_block(planar[pending_write], produced[pending_write]);
+            return read_block(chunky[next]);
+        });
+
+        size_t rows = (filled[cur] + layout.width - 1) / layout.width;
+        produced[cur] = layout.planar_size(rows);
+        bool ok = chunky_to_planar(std::span<const uint8_t>(chunky[cur].data(), filled[cur]),
+                                   std::span<uint8_t>(planar[cur].data(), produced[cur]), layout);
+        pixels_in += filled[cur];
+
+        filled[next] = io.get();
+        if (!ok || !write_ok) return false;
+        pending_write = cur;
+        bytes_out += produced[cur];
+    }
+
+    if (pending_write >= 0) write_ok = write_ok && write_block(planar[pending_write], produced[pending_write]);
+    out.flush();
+    return write_ok && out.good();
+}
+
+bool preshift_sprite(std::span<const uint8_t> chunky, std::span<uint8_t> out, const SpriteFormat& format) {
+    const int planes = format.planes;
+    if (planes < 1 || planes > 8 || format.width == 0 || format.height == 0) return false;
+    if (chunky.size() < format.width * format.height || out.size() < format.frame_size()) return false;
+
+    // Plane-major conversion gives one contiguous word row per plane
+    PlaneLayout layout{ planes, false, format.width, 0 };
+    const size_t groups = layout.groups_per_row();
+    std::vector<uint8_t> planar;
+    if (!chunky_to_planar(chunky.first(format.width * format.height), planar, layout)) return false;
+
+    // words[plane][row][group] in host order; the extra plane is the OR mask
+    const size_t plane_words = groups * format.height;
+    std::vector<uint16_t> words(plane_words * (planes + 1), 0);
+    uint16_t* mask = &words[plane_words * planes];
+    for (int p = 0; p < planes; ++p) {
+        for (size_t i = 0; i < plane_words; ++i) {
+            const uint8_t* src = &planar[(p * plane_words + i) * 2];
+            uint16_t w = static_cast<uint16_t>((src[0] << 8) | src[1]);
+            words[p * plane_words + i] = w;
+            mask[i] |= w;
+        }
+    }
+
+    const size_t out_groups = format.shifted_groups();
+    const size_t words_per_group = planes + 1;
+    std::vector<uint16_t> shifted(out_groups);
+
+    for (int shift = 0; shift < 16; ++shift) {
+        uint8_t* frame = out.data() + shift * format.shift_size();
+        uint8_t* mask_block = frame + out_groups * 2 * planes * format.height;
+
+        for (size_t y = 0; y < format.height; ++y) {
+            for (int p = 0; p <= planes; ++p) {
+                // Shift a whole row: each output word is a 32-bit window of two source words
+                const uint16_t* row = &words[p * plane_words + y * groups];
+                uint32_t window = 0;
+                for (size_t g = 0; g < out_groups; ++g) {
+                    window = (window << 16) | (g < groups ? row[g] : 0);
+                    shifted[g] = static_cast<uint16_t>(window >> shift);
+                }
+
+                bool is_mask = (p == planes);
+                for (size_t g = 0; g < out_groups; ++g) {
+                    uint16_t w = is_mask ? static_cast<uint16_t>(~shifted[g]) : shifted[g];
+                    uint8_t* dst;
+                    if (format.mask == MaskPlacement::Interleaved) {
+                        size_t slot = is_mask ? 0 : p + 1;
+                        dst = frame + ((y * out_groups + g) * words_per_group + slot) * 2;
+                    } else if (is_mask) {
+                        dst = mask_block + (y * out_groups + g) * 2;
+                    } else {
+                        dst = frame + ((y * out_groups + g) * planes + p) * 2;
+                    }
+                    store_be16(dst, w);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace libste
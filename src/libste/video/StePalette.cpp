@@ -0,0 +1,212 @@
+#include "StePalette.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+
+namespace libste {
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',';
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && is_space(s.front())) s.remove_prefix(1);
+    while (!s.empty() && is_space(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+std::string_view next_line(std::string_view& text) {
+    size_t nl = text.find('\n');
+    std::string_view line = text.substr(0, nl);
+    text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+std::string_view next_token(std::string_view& text) {
+    size_t i = 0;
+    while (i < text.size() && is_space(text[i])) ++i;
+    size_t start = i;
+    while (i < text.size() && !is_space(text[i])) ++i;
+    std::string_view token = text.substr(start, i - start);
+    text.remove_prefix(i);
+    return token;
+}
+
+bool parse_uint(std::string_view token, int base, uint32_t& value) {
+    if (token.empty()) return false;
+    auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value, base);
+    return ec == std::errc() && ptr == token.data() + token.size();
+}
+
+// "R G B [name]" triplets shared by the GIMP and JASC readers
+bool parse_rgb_triplet(std::string_view line, Rgb8& out) {
+    uint32_t c[3];
+    for (auto& v : c) {
+        if (!parse_uint(next_token(line), 10, v) || v > 255) return false;
+    }
+    out = { static_cast<uint8_t>(c[0]), static_cast<uint8_t>(c[1]), static_cast<uint8_t>(c[2]) };
+    return true;
+}
+
+bool read_gimp(std::string_view text, std::vector<Rgb8>& out) {
+    if (trim(next_line(text)) != "GIMP Palette") return false;
+    while (!text.empty()) {
+        std::string_view line = trim(next_line(text));
+        if (line.empty() || line[0] == '#') continue;
+        if (line.starts_with("Name:") || line.starts_with("Columns:")) continue;
+        Rgb8 c;
+        if (!parse_rgb_triplet(line, c)) return false;
+        out.push_back(c);
+    }
+    return true;
+}
+
+bool read_jasc(std::string_view text, std::vector<Rgb8>& out) {
+    if (trim(next_line(text)) != "JASC-PAL") return false;
+    next_line(text); // Version ("0100")
+    uint32_t count = 0;
+    if (!parse_uint(trim(next_line(text)), 10, count)) return false;
+    // The count is only a claim; it can't exceed the lines that follow
+    if (count > std::count(text.begin(), text.end(), '\n') + 1) return false;
+    out.reserve(out.size() + count);
+    for (uint32_t i = 0; i < count; ++i) {
+        Rgb8 c;
+        if (text.empty() || !parse_rgb_triplet(trim(next_line(text)), c)) return false;
+        out.push_back(c);
+    }
+    return true;
+}
+
+bool read_hex_list(std::string_view text, std::vector<Rgb8>& out) {
+    while (true) {
+        std::string_view token = next_token(text);
+        if (token.empty()) return true;
+        Rgb8 c;
+        if (!parse_hex_rgb(token, c)) return false;
+        out.push_back(c);
+    }
+}
+
+constexpr char kHexDigits[] = "0123456789ABCDEF";
+
+void append_hex(std::string& out, uint32_t value, int digits) {
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+        out.push_back(kHexDigits[(value >> shift) & 0x0F]);
+    }
+}
+
+} // namespace
+
+bool parse_hex_rgb(std::string_view text, Rgb8& out) {
+    if (text.starts_with('#') || text.starts_with('$')) text.remove_prefix(1);
+    else if (text.starts_with("0x") || text.starts_with("0X")) text.remove_prefix(2);
+    uint32_t rgb;
+    if (text.size() != 6 || !parse_uint(text, 16, rgb)) return false;
+    out = { static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb) };
+    return true;
+}
+
+bool parse_ste_word(std::string_view text, uint16_t& out) {
+    if (text.starts_with('#') || text.starts_with('$')) text.remove_prefix(1);
+    else if (text.starts_with("0x") || text.starts_with("0X")) text.remove_prefix(2);
+    uint32_t word;
+    if (text.empty() || text.size() > 4 || !parse_uint(text, 16, word)) return false;
+    out = static_cast<uint16_t>(word & 0x0FFF);
+    return true;
+}
+
+bool read_palette(std::string_view text, PaletteFormat format, std::vector<Rgb8>& out) {
+    if (format == PaletteFormat::Auto) {
+        std::string_view head = trim(text.substr(0, 16));
+        if (head.starts_with("GIMP Palette")) format = PaletteFormat::Gimp;
+        else if (head.starts_with("JASC-PAL")) format = PaletteFormat::Jasc;
+        else format = PaletteFormat::Hex;
+    }
+    switch (format) {
+        case PaletteFormat::Gimp: return read_gimp(text, out);
+        case PaletteFormat::Jasc: return read_jasc(text, out);
+        default: return read_hex_list(text, out);
+    }
+}
+
+bool read_ste_words(std::string_view text, std::vector<uint16_t>& out) {
+    while (true) {
+        std::string_view token = next_token(text);
+        if (token.empty()) return true;
+        uint16_t word;
+        if (!parse_ste_word(token, word)) return false;
+        out.push_back(word);
+    }
+}
+
+std::vector<uint16_t> palette_to_ste(std::span<const Rgb8> colors) {
+    std::vector<uint16_t> words(colors.size());
+    for (size_t i = 0; i < colors.size(); ++i) {
+        words[i] = rgb_to_ste_word(colors[i]);
+    }
+    return words;
+}
+
+std::vector<Rgb8> ste_to_palette(std::span<const uint16_t> words) {
+    std::vector<Rgb8> colors(words.size());
+    for (size_t i = 0; i < words.size(); ++i) {
+        colors[i] = ste_word_to_rgb(words[i]);
+    }
+    return colors;
+}
+
+void emit_ste_words(std::span<const uint16_t> words, PaletteEmit style, const std::string& name, std::string& out) {
+    out.reserve(out.size() + words.size() * 8 + name.size() + 64);
+    switch (style) {
+        case PaletteEmit::Asm:
+            if (!name.empty()) out += name + ":\n";
+            // 8 words per DC.W line, like a DEGAS palette dump
+            for (size_t i = 0; i < words.size(); ++i) {
+                out += (i % 8 == 0) ? "    DC.W $" : ",$";
+                append_hex(out, words[i], 4);
+                if (i % 8 == 7 || i + 1 == words.size()) out += '\n';
+            }
+            break;
+        case PaletteEmit::CArray:
+            out += "const unsigned short " + (name.empty() ? std::string("palette") : name) +
+                   "[" + std::to_string(words.size()) + "] = {\n";
+            for (size_t i = 0; i < words.size(); ++i) {
+                out += (i % 8 == 0) ? "    0x" : " 0x";
+                append_hex(out, words[i], 4);
+                if (i + 1 != words.size()) out += ',';
+                if (i % 8 == 7 || i + 1 == words.size()) out += '\n';
+            }
+            out += "};\n";
+            break;
+        default:
+            for (uint16_t w : words) {
+                out += '$';
+                append_hex(out, w, 4);
+                out += '\n';
+            }
+            break;
+    }
+}
+
+void emit_rgb_palette(std::span<const Rgb8> colors, PaletteEmit style, const std::string& name, std::string& out) {
+    out.reserve(out.size() + colors.size() * 16 + 64);
+    if (style == PaletteEmit::Gimp) {
+        out += "GIMP Palette\nName: " + (name.empty() ? std::string("STE") : name) + "\n#\n";
+        char line[32];
+        for (const auto& c : colors) {
+            std::snprintf(line, sizeof(line), "%3u %3u %3u\n", c.r, c.g, c.b);
+            out += line;
+        }
+        return;
+    }
+    for (const auto& c : colors) {
+        out += '#';
+        append_hex(out, (uint32_t(c.r) << 16) | (uint32_t(c.g) << 8) | c.b, 6);
+        out += '\n';
+    }
+}
+
+} // namespace libste
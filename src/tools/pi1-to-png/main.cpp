@@ -1,6 +1,9 @@
+#include "BufferStore.hpp"
+#include "Planar.hpp"
 #include <iostream>
+#include <cstring>
 #include <vector>
-#include <fstream>
+#include <algorithm>
 #include <cstdint>
 #include <arpa/inet.h>
 
@@ -22,57 +25,46 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    std::ifstream ifs(argv[1], std::ios::binary);
-    if (!ifs) {
+    std::vector<uint8_t> storage;
+    std::span<const uint8_t> file;
+    if (!libste::load_input(argv[1], storage, file)) {
         std::cerr << "Error: Could not open " << argv[1] << "\n";
         return 1;
     }
+    // Short files read as zeros past the end
+    std::vector<uint8_t> pi1(2 + 32 + 32000, 0);
+    if (!file.empty()) std::memcpy(pi1.data(), file.data(), std::min(file.size(), pi1.size()));
 
-    // Degas PI1 files start with a resolution word (0 = Low Res)
-    uint16_t res;
-    ifs.read((char*)&res, 2);
-
-    // Read Palette (16 words / 32 bytes)
+    // Degas PI1 files start with a resolution word (0 = Low Res),
+    // then the palette (16 words / 32 bytes)
     uint16_t raw_palette[16];
-    ifs.read((char*)raw_palette, 32);
+    std::memcpy(raw_palette, &pi1[2], 32);
     uint8_t palette_rgb[16][3];
     for(int i=0; i<16; ++i) {
         atari_to_rgb(ntohs(raw_palette[i]), palette_rgb[i][0], palette_rgb[i][1], palette_rgb[i][2]);
     }
 
     // Read Image Data (32,000 bytes)
-    std::vector<uint8_t> screen(32000);
-    ifs.read((char*)screen.data(), 32000);
+    std::span<const uint8_t> screen(&pi1[34], 32000);
 
-    // De-planarize into RGBA buffer (320x200)
+    // De-planarize (4 interleaved planes), then look up the palette into RGBA (320x200)
+    std::vector<uint8_t> chunky(320 * 200);
+    libste::planar_to_chunky(screen, chunky, libste::kLowRes);
     std::vector<uint8_t> rgba(320 * 200 * 4);
-    for (int y = 0; y < 200; ++y) {
-        for (int x_chunk = 0; x_chunk < 20; ++x_chunk) { // 20 chunks of 16 pixels
-            // Each chunk is 4 words (8 bytes) representing 16 pixels
-            size_t offset = (y * 160) + (x_chunk * 8);
-            uint16_t p0 = ntohs(*(uint16_t*)&screen[offset]);
-            uint16_t p1 = ntohs(*(uint16_t*)&screen[offset + 2]);
-            uint16_t p2 = ntohs(*(uint16_t*)&screen[offset + 4]);
-            uint16_t p3 = ntohs(*(uint16_t*)&screen[offset + 6]);
-
-            for (int p = 0; p < 16; ++p) {
-                int bit = 15 - p;
-                int color_idx = ((p0 >> bit) & 1) | 
-                                (((p1 >> bit) & 1) << 1) | 
-                                (((p2 >> bit) & 1) << 2) | 
-                                (((p3 >> bit) & 1) << 3);
-                
-                int px = (x_chunk * 16) + p;
-                int rgba_idx = (y * 320 + px) * 4;
-                rgba[rgba_idx]     = palette_rgb[color_idx][0];
-                rgba[rgba_idx + 1] = palette_rgb[color_idx][1];
-                rgba[rgba_idx + 2] = palette_rgb[color_idx][2];
-                rgba[rgba_idx + 3] = 255; // Alpha
-            }
-        }
+    for (size_t i = 0; i < chunky.size(); ++i) {
+        const uint8_t* rgb = palette_rgb[chunky[i]];
+        rgba[i * 4]     = rgb[0];
+        rgba[i * 4 + 1] = rgb[1];
+        rgba[i * 4 + 2] = rgb[2];
+        rgba[i * 4 + 3] = 255; // Alpha
     }
 
-    if (stbi_write_png(argv[2], 320, 200, 4, rgba.data(), 320 * 4)) {
+    std::vector<uint8_t> png;
+    auto append = [](void* context, void* data, int size) {
+        auto* out = static_cast<std::vector<uint8_t>*>(context);
+        out->insert(out->end(), static_cast<uint8_t*>(data), static_cast<uint8_t*>(data) + size);
+    };
+    if (stbi_write_png_to_func(append, &png, 320, 200, 4, rgba.data(), 320 * 4) && libste::save_output(argv[2], png)) {
         std::cout << "Successfully recovered image to " << argv[2] << "\n";
     } else {
         std::cerr << "Error writing PNG file.\n";
@@ -1,57 +1,398 @@
+#include "Packer.hpp"
+#include "ResourcePack.hpp"
+#include "BufferStore.hpp"
+#include <cstdlib>
 #include <iostream>
-#include <fstream>
 #include <vector>
 #include <string>
-#include <iomanip>
+#include <array>
+#include <cstring>
 #include <algorithm>
+#include <filesystem>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cout << "Usage: st-bin2rsx <input_file> <array_name> [output_header.h]\n";
-        return 1;
+using namespace libste;
+
+enum class OutputMode { C, Asm, Incbin };
+
+// Read-only view of the input file (or pipeline buffer); the mapping lives
+// as long as this does
+class MappedInput {
+public:
+    ~MappedInput() {
+        if (map_) ::munmap(map_, size_);
+    }
+
+    bool open(const std::string& path) {
+        if (is_buffer_path(path)) return load_input(path, storage_, view_);
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        // Pipes, FIFOs and /dev/stdin report no size: read those instead
+        if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+            bool ok = read_all(fd);
+            ::close(fd);
+            return ok;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* map = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        map_ = map;
+        ::madvise(map_, size_, MADV_SEQUENTIAL);
+        view_ = { static_cast<const uint8_t*>(map_), size_ };
+        ::close(fd);
+        return true;
     }
 
-    std::string input_path = argv[1];
-    std::string array_name = argv[2];
-    std::string output_path = (argc > 3) ? argv[3] : (array_name + ".h");
+    std::span<const uint8_t> data() const { return view_; }
 
-    std::ifstream ifs(input_path, std::ios::binary);
-    if (!ifs) {
-        std::cerr << "Error: Could not open " << input_path << "\n";
+private:
+    bool read_all(int fd) {
+        uint8_t chunk[65536];
+        while (true) {
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n == 0) break;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            storage_.insert(storage_.end(), chunk, chunk + n);
+        }
+        view_ = storage_;
+        return true;
+    }
+
+    void* map_ = nullptr;
+    size_t size_ = 0;
+    std::vector<uint8_t> storage_;
+    std::span<const uint8_t> view_;
+};
+
+static const char kHexDigits[] = "0123456789ABCDEF";
+
+// "0xNN, " for every byte value, built once
+static const std::array<std::array<char, 6>, 256> kCByteTable = [] {
+    std::array<std::array<char, 6>, 256> t{};
+    for (int i = 0; i < 256; ++i) t[i] = { '0', 'x', kHexDigits[i >> 4], kHexDigits[i & 15], ',', ' ' };
+    return t;
+}();
+
+// C array body: 12 bytes per line, formatted straight into one buffer
+static void emit_c_bytes(std::string& out, std::span<const uint8_t> data) {
+    size_t base = out.size();
+    out.resize(base + data.size() * 6 + (data.size() / 12) * 5);
+    char* p = out.data() + base;
+    for (size_t i = 0; i < data.size(); ++i) {
+        std::memcpy(p, kCByteTable[data[i]].data(), 6);
+        if (i == data.size() - 1) {
+            p += 4;  // No separator after the last byte
+        } else if ((i + 1) % 12 == 0) {
+            std::memcpy(p + 6, "\n    ", 5);
+            p += 11;
+        } else {
+            p += 6;
+        }
+    }
+    out.resize(p - out.data());
+}
+
+// Devpac/vasm data lines: dc.b $NN (16 per line) or dc.l $NNNNNNNN (8 per line).
+// Longs are the bytes in order, since the 68000 is big-endian.
+static void emit_asm_data(std::string& out, std::span<const uint8_t> data, bool use_long) {
+    size_t i = 0;
+    if (use_long) {
+        size_t longs = data.size() / 4;
+        for (size_t l = 0; l < longs; l += 8) {
+            out += "\tdc.l\t";
+            size_t count = std::min<size_t>(8, longs - l);
+            for (size_t k = 0; k < count; ++k, i += 4) {
+                char word[10] = { '$' };
+                for (int b = 0; b < 4; ++b) {
+                    word[1 + b * 2] = kHexDigits[data[i + b] >> 4];
+                    word[2 + b * 2] = kHexDigits[data[i + b] & 15];
+                }
+                word[9] = k + 1 < count ? ',' : '\n';
+                out.append(word, 10);
+            }
+        }
+    }
+    while (i < data.size()) {
+        out += "\tdc.b\t";
+        size_t count = std::min<size_t>(16, data.size() - i);
+        for (size_t k = 0; k < count; ++k, ++i) {
+            char byte[4] = { '$', kHexDigits[data[i] >> 4], kHexDigits[data[i] & 15], k + 1 < count ? ',' : '\n' };
+            out.append(byte, 4);
+        }
+    }
+}
+
+static std::string hex32(uint32_t v) {
+    char text[12];
+    std::snprintf(text, sizeof(text), "$%08X", v);
+    return text;
+}
+
+// Manifest mode: every asset in one aligned blob behind an index of
+// { offset, size, packed_size, name_hash } longs and an enum of IDs
+static int build_pack(const std::string& manifest_path, const std::string& pack_name, std::string output_path,
+                      PackFormat format, OutputMode mode, bool use_long, size_t align) {
+    std::string guard = pack_name;
+    std::transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
+
+    std::vector<ManifestItem> items;
+    if (!read_manifest(manifest_path, guard, items) || items.empty()) {
+        std::cerr << "Error: Could not read " << manifest_path << " (missing, empty or duplicate IDs)\n";
         return 1;
     }
 
-    std::vector<uint8_t> data((std::istreambuf_iterator<char>(ifs)), 
-                               std::istreambuf_iterator<char>());
+    // Asset paths are relative to the manifest
+    std::filesystem::path base = std::filesystem::path(manifest_path).parent_path();
+    ResourcePack pack;
+    uint64_t unpacked_total = 0;
+    for (const auto& item : items) {
+        MappedInput input;
+        std::string path = (base / item.path).string();
+        if (!input.open(path)) {
+            std::cerr << "Error: Could not open " << path << "\n";
+            return 1;
+        }
+        if (!add_pack_asset(pack, item, input.data(), format, align)) {
+            std::cerr << "Error: Packed stream for " << path << " failed verification.\n";
+            return 1;
+        }
+        unpacked_total += input.data().size();
+    }
+    const auto& blob = pack.blob;
+    const size_t count = pack.entries.size();
+
+    if (output_path.empty()) output_path = pack_name + (mode == OutputMode::C ? ".h" : ".s");
+    std::string blob_path;
+    if (mode == OutputMode::Incbin) {
+        blob_path = std::filesystem::path(output_path).replace_extension(".bin").string();
+        if (!save_output(blob_path, blob)) {
+            std::cerr << "Error: Could not create " << blob_path << "\n";
+            return 1;
+        }
+    }
+
+    std::string out;
+    if (mode == OutputMode::C) {
+        out.reserve(blob.size() * 6 + blob.size() / 2 + count * 96 + 1024);
+        out += "#ifndef " + guard + "_H\n";
+        out += "#define " + guard + "_H\n\n";
+        out += "// Generated by st-bin2rsx\n";
+        out += "// Manifest: " + manifest_path + "\n\n";
+        out += "enum " + pack_name + "_id {\n";
+        for (size_t i = 0; i < count; ++i) {
+            out += "    " + pack.entries[i].id + " = " + std::to_string(i) + ", // " + pack.entries[i].name + "\n";
+        }
+        out += "    " + guard + "_COUNT = " + std::to_string(count) + "\n};\n\n";
+        out += "// offset, size, packed_size (0 = stored), FNV-1a hash of the name\n";
+        out += "static const unsigned long " + pack_name + "_index[" + std::to_string(count) + "][4] = {\n";
+        for (const auto& e : pack.entries) {
+            char line[96];
+            std::snprintf(line, sizeof(line), "    { 0x%08X, 0x%08X, 0x%08X, 0x%08X }, // ", e.offset, e.size, e.packed_size, e.name_hash);
+            out += line + e.name + "\n";
+        }
+        out += "};\n\n";
+        out += "const unsigned char " + pack_name + "[" + std::to_string(blob.size()) + "] = {\n    ";
+        emit_c_bytes(out, blob);
+        out += "\n};\n\n";
+        out += "#endif // " + guard + "_H\n";
+    } else {
+        out.reserve(blob.size() * (use_long ? 3 : 4) + blob.size() / 2 + count * 96 + 1024);
+        out += "; Generated by st-bin2rsx\n";
+        out += "; Manifest: " + manifest_path + "\n";
+        out += "; Index entries: offset, size, packed_size (0 = stored), FNV-1a name hash\n";
+        for (size_t i = 0; i < count; ++i) {
+            out += pack.entries[i].id + "\tequ\t" + std::to_string(i) + "\n";
+        }
+        out += guard + "_COUNT\tequ\t" + std::to_string(count) + "\n";
+        out += guard + "_ENTRY_SIZE\tequ\t16\n";
+        out += guard + "_SIZE\tequ\t" + std::to_string(blob.size()) + "\n\n";
+        out += "\txdef\t" + pack_name + "_index\n";
+        out += "\txdef\t" + pack_name + "\n";
+        out += "\txdef\t" + pack_name + "_end\n\n";
+        out += "\tsection\tdata\n";
+        out += "\teven\n";
+        out += pack_name + "_index:\n";
+        for (const auto& e : pack.entries) {
+            out += "\tdc.l\t" + hex32(e.offset) + "," + hex32(e.size) + "," + hex32(e.packed_size) + "," +
+                   hex32(e.name_hash) + "\t; " + e.name + "\n";
+        }
+        out += pack_name + ":\n";
+        if (mode == OutputMode::Incbin) out += "\tincbin\t\"" + blob_path + "\"\n";
+        else emit_asm_data(out, blob, use_long);
+        out += pack_name + "_end:\n";
+        out += "\teven\n";
+    }
 
-    std::ofstream ofs(output_path);
-    if (!ofs) {
+    if (!save_output(output_path, std::span(reinterpret_cast<const uint8_t*>(out.data()), out.size()))) {
         std::cerr << "Error: Could not create " << output_path << "\n";
         return 1;
     }
 
-    // Header guard
+    std::cout << "Packed " << count << " assets (" << unpacked_total << " -> " << blob.size() << " bytes) into "
+              << output_path << "\n";
+    return 0;
+}
+
+static void print_usage() {
+    std::cout << "Usage: st-bin2rsx [options] <input_file> <array_name> [output]\n";
+    std::cout << "       st-bin2rsx [options] --manifest <list.txt> <pack_name> [output]\n";
+    std::cout << "Options:\n";
+    std::cout << "  --pack rle|lz4  Compress the data (adds <NAME>_UNPACKED_SIZE)\n";
+    std::cout << "  --asm           Devpac/vasm source with dc.b lines instead of a C header\n";
+    std::cout << "  --long          With --asm, emit dc.l lines (about half the text)\n";
+    std::cout << "  --incbin        Devpac/vasm source that incbins the input, plus symbols\n";
+    std::cout << "  --manifest <f>  Build one blob from every \"<path> [ID]\" line of <f>,\n";
+    std::cout << "                  with an index table and an enum of IDs\n";
+    std::cout << "  --align <n>     Asset alignment inside the blob, 1-65536 (default: 2)\n";
+}
+
+int main(int argc, char* argv[]) {
+    PackFormat format = PackFormat::None;
+    OutputMode mode = OutputMode::C;
+    bool use_long = false;
+    std::string manifest;
+    size_t align = 2;
+    bool align_given = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--pack" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "rle") format = PackFormat::Rle;
+            else if (name == "lz4") format = PackFormat::Lz4;
+            else {
+                std::cerr << "Error: Unknown pack format " << name << " (use rle or lz4)\n";
+                return 1;
+            }
+        } else if (arg == "--asm") {
+            mode = OutputMode::Asm;
+        } else if (arg == "--incbin") {
+            mode = OutputMode::Incbin;
+        } else if (arg == "--long") {
+            use_long = true;
+        } else if (arg == "--manifest" && i + 1 < argc) {
+            manifest = argv[++i];
+        } else if (arg == "--align" && i + 1 < argc) {
+            char* end = nullptr;
+            unsigned long value = std::strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || argv[i][0] == '-' || value == 0 || value > 65536) {
+                std::cerr << "Error: --align needs a byte count from 1 to 65536.\n";
+                return 1;
+            }
+            align = value;
+            align_given = true;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    // A single array has nothing to align against
+    if (align_given && manifest.empty()) {
+        std::cerr << "Error: --align only applies to --manifest packs.\n";
+        return 1;
+    }
+    if (!manifest.empty() && !args.empty()) {
+        return build_pack(manifest, args[0], args.size() > 1 ? args[1] : "", format, mode, use_long, align);
+    }
+    if (args.size() < 2) {
+        print_usage();
+        return 1;
+    }
+    if (mode == OutputMode::Incbin && format != PackFormat::None) {
+        std::cerr << "Error: --incbin includes the input file as is and cannot be combined with --pack.\n";
+        return 1;
+    }
+
+    std::string input_path = args[0];
+    std::string array_name = args[1];
+    std::string output_path = (args.size() > 2) ? args[2] : (array_name + (mode == OutputMode::C ? ".h" : ".s"));
+
+    MappedInput input;
+    if (!input.open(input_path)) {
+        std::cerr << "Error: Could not open " << input_path << "\n";
+        return 1;
+    }
+    std::span<const uint8_t> data = input.data();
+
+    // Pack, then depack once to prove the stream before it ends up in a build
+    size_t unpacked_size = data.size();
+    std::vector<uint8_t> packed;
+    if (format != PackFormat::None) {
+        std::vector<uint8_t> check;
+        pack_data(data, format, packed);
+        bool ok = depack_data(packed, format, check, unpacked_size);
+        if (!ok || !std::equal(check.begin(), check.end(), data.begin(), data.end())) {
+            std::cerr << "Error: Packed stream failed verification.\n";
+            return 1;
+        }
+        data = packed;
+    }
+
     std::string guard = array_name;
     std::transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
-    
-    ofs << "#ifndef " << guard << "_H\n";
-    ofs << "#define " << guard << "_H\n\n";
-    ofs << "// Generated by st-bin2rsx\n";
-    ofs << "// Source: " << input_path << "\n";
-    ofs << "const unsigned char " << array_name << "[" << data.size() << "] = {\n    ";
+    const char* pack_name = format == PackFormat::Rle ? "RLE (PackBits)" : "LZ4 raw block";
 
-    for (size_t i = 0; i < data.size(); ++i) {
-        ofs << "0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << (int)data[i];
-        
-        if (i != data.size() - 1) {
-            ofs << ", ";
-            if ((i + 1) % 12 == 0) ofs << "\n    ";
+    std::string out;
+    if (mode == OutputMode::C) {
+        out.reserve(data.size() * 6 + data.size() / 2 + 512);
+        out += "#ifndef " + guard + "_H\n";
+        out += "#define " + guard + "_H\n\n";
+        out += "// Generated by st-bin2rsx\n";
+        out += "// Source: " + input_path + "\n";
+        if (format != PackFormat::None) {
+            out += "// Packed: " + std::string(pack_name) + ", " + std::to_string(unpacked_size) + " -> " +
+                   std::to_string(data.size()) + " bytes\n";
+            out += "#define " + guard + "_UNPACKED_SIZE " + std::to_string(unpacked_size) + "\n";
+        }
+        out += "const unsigned char " + array_name + "[" + std::to_string(data.size()) + "] = {\n    ";
+        emit_c_bytes(out, data);
+        out += "\n};\n\n";
+        out += "#endif // " + guard + "_H\n";
+    } else {
+        out.reserve(data.size() * (use_long ? 3 : 4) + data.size() / 2 + 512);
+        out += "; Generated by st-bin2rsx\n";
+        out += "; Source: " + input_path + "\n";
+        if (format != PackFormat::None) {
+            out += "; Packed: " + std::string(pack_name) + "\n";
+            out += guard + "_UNPACKED_SIZE\tequ\t" + std::to_string(unpacked_size) + "\n";
         }
+        out += guard + "_SIZE\tequ\t" + std::to_string(data.size()) + "\n\n";
+        out += "\txdef\t" + array_name + "\n";
+        out += "\txdef\t" + array_name + "_end\n\n";
+        out += "\tsection\tdata\n";
+        out += "\teven\n";
+        out += array_name + ":\n";
+        if (mode == OutputMode::Incbin) out += "\tincbin\t\"" + input_path + "\"\n";
+        else emit_asm_data(out, data, use_long);
+        out += array_name + "_end:\n";
+        out += "\teven\n";
     }
 
-    ofs << "\n};\n\n";
-    ofs << "#endif // " << guard << "_H\n";
+    if (!save_output(output_path, std::span(reinterpret_cast<const uint8_t*>(out.data()), out.size()))) {
+        std::cerr << "Error: Could not create " << output_path << "\n";
+        return 1;
+    }
 
-    std::cout << "Successfully converted " << input_path << " to " << output_path << "\n";
+    std::cout << "Successfully converted " << input_path << " to " << output_path;
+    if (format != PackFormat::None) {
+        std::cout << " (" << unpacked_size << " -> " << data.size() << " bytes)";
+    }
+    std::cout << "\n";
     return 0;
 }
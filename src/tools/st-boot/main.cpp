@@ -0,0 +1,95 @@
+#include "DiskHandler.hpp"
+#include "DiskStats.hpp"
+#include "BufferStore.hpp"
+#include "BootSector.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace libste;
+
+int main(int argc, char* argv[]) {
+    StatsReport report(take_stats_flag(argc, argv));
+
+    std::string oem, serial;
+    bool has_serial = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--oem" && i + 1 < argc) {
+            oem = argv[++i];
+        } else if (arg == "--serial" && i + 1 < argc) {
+            serial = argv[++i];
+            has_serial = true;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty() || paths.size() > 2) {
+        std::cout << "Usage: st-boot [--oem NAME] [--serial HEX|random] [--stats] <disk.st> [boot.bin|boot.prg]"
+                  << std::endl;
+        return 1;
+    }
+
+    // The serial is 24 bits (BootSector::SERIAL_OFFSET)
+    uint32_t serial_value = 0;
+    if (has_serial && serial != "random") {
+        if (serial.empty() || serial.size() > 6 || serial.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+            std::cerr << "Error: --serial takes 1 to 6 hex digits or 'random', not " << serial << std::endl;
+            return 1;
+        }
+        serial_value = static_cast<uint32_t>(std::strtoul(serial.c_str(), nullptr, 16));
+    }
+
+    DiskHandler disk;
+    if (!disk.load_from_file(paths[0])) {
+        std::cerr << "Error: Could not open disk image: " << paths[0] << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> code;
+    std::string error;
+    if (paths.size() > 1) {
+        std::vector<uint8_t> storage;
+        std::span<const uint8_t> file;
+        if (!load_input(paths[1], storage, file)) {
+            std::cerr << "Error: Could not read boot program: " << paths[1] << std::endl;
+            return 1;
+        }
+        if (!load_boot_code(file, code, error)) {
+            std::cerr << "Error: " << paths[1] << ": " << error << std::endl;
+            return 1;
+        }
+    }
+
+    // Header fields first: the checksum covers them
+    bool was_bootable = disk.verify_tos_checksum();
+    if (!oem.empty()) set_oem_name(disk, oem);
+    if (serial == "random") {
+        set_serial(disk, std::random_device{}());
+    } else if (has_serial) {
+        set_serial(disk, serial_value);
+    }
+
+    if (!code.empty()) {
+        if (!install_boot_code(disk, code, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        std::cout << "Installed " << code.size() << " bytes of boot code (" << BootSector::CODE_MAX - code.size()
+                  << " free)" << std::endl;
+    } else if (was_bootable) {
+        disk.apply_tos_checksum();
+    }
+
+    if (!disk.save_to_file(paths[0])) {
+        std::cerr << "Error: Could not save " << paths[0] << std::endl;
+        return 1;
+    }
+    std::cout << "Disk: " << paths[0] << " " << (disk.verify_tos_checksum() ? "[bootable, checksum $1234]"
+                                                                             : "[not bootable]")
+              << std::endl;
+    return 0;
+}
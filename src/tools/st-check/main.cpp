@@ -1,10 +1,58 @@
 #include "DiskHandler.hpp"
+#include "DiskStats.hpp"
+#include "FsCheck.hpp"
 #include <iostream>
+#include <string>
+
 using namespace libste;
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) return 1;
+    StatsReport report_stats(take_stats_flag(argc, argv));
+
+    bool repair = false;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--repair") repair = true;
+        else path = arg;
+    }
+    if (path.empty()) {
+        std::cout << "Usage: st-check [--repair] [--stats] <file.st>" << std::endl;
+        return 1;
+    }
+
     DiskHandler disk;
-    if (!disk.load_from_file(argv[1])) return 1;
-    std::cout << "Disk: " << argv[1] << " [Check PASSED]" << std::endl;
+    if (!disk.load_from_file(path)) {
+        std::cerr << "Could not open disk image: " << path << std::endl;
+        return 1;
+    }
+
+    FsCheckReport report = check_filesystem(disk, repair);
+
+    std::cout << "Disk: " << path << std::endl;
+    std::cout << "  Boot sector: " << (report.boot_checksum_ok ? "checksum $1234, bootable" : "not bootable")
+              << std::endl;
+    std::cout << "  " << report.files << " files, " << report.directories << " directories" << std::endl;
+    std::cout << "  Clusters: " << report.used_clusters << " used, " << report.free_clusters << " free, "
+              << report.bad_clusters << " bad" << std::endl;
+    for (const auto& p : report.problems) {
+        std::cout << "  [" << to_string(p.kind) << "] " << (p.path.empty() ? "" : p.path + ": ") << p.message
+                  << std::endl;
+    }
+
+    if (report.clean()) {
+        std::cout << "Disk: " << path << " [Check PASSED]" << std::endl;
+        return 0;
+    }
+    if (!repair) {
+        std::cout << "Disk: " << path << " [Check FAILED] " << report.problems.size()
+                  << " problem(s); run with --repair to fix" << std::endl;
+        return 1;
+    }
+    if (!disk.save_to_file(path)) {
+        std::cerr << "Error: Could not save the repaired image." << std::endl;
+        return 1;
+    }
+    std::cout << "Disk: " << path << " [REPAIRED] " << report.problems.size() << " problem(s) fixed" << std::endl;
     return 0;
 }
@@ -0,0 +1,77 @@
+#include "DiskHandler.hpp"
+#include "DiskStats.hpp"
+#include "BufferStore.hpp"
+#include "Defrag.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace libste;
+
+// One path per line; blank lines and '#' comments are skipped
+static bool read_order_file(const std::string& path, std::vector<std::string>& order) {
+    auto in = open_input_stream(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(*in, line)) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) continue;
+        size_t last = line.find_last_not_of(" \t\r");
+        order.push_back(line.substr(first, last - first + 1));
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    StatsReport report_stats(take_stats_flag(argc, argv));
+
+    DefragOptions options;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--order" && i + 1 < argc) {
+            std::string list = argv[++i];
+            if (!read_order_file(list, options.load_order)) {
+                std::cerr << "Could not read load order: " << list << std::endl;
+                return 1;
+            }
+        } else if (arg == "--align" && i + 1 < argc) {
+            options.track_aligned.push_back(argv[++i]);
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty() || paths.size() > 2) {
+        std::cout << "Usage: st-defrag [--order list.txt] [--align NAME]... [--stats] <disk.st> [out.st]" << std::endl;
+        return 1;
+    }
+
+    DiskHandler disk;
+    if (!disk.load_from_file(paths[0])) {
+        std::cerr << "Could not open disk image: " << paths[0] << std::endl;
+        return 1;
+    }
+
+    DefragResult result;
+    std::string error;
+    if (!defragment(disk, options, result, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    const std::string& out = paths.size() > 1 ? paths[1] : paths[0];
+    if (!disk.save_to_file(out)) {
+        std::cerr << "Error: Could not save " << out << std::endl;
+        return 1;
+    }
+
+    std::cout << "Disk: " << out << std::endl;
+    std::cout << "  " << result.files << " files, " << result.directories << " directories, "
+              << result.clusters_moved << " clusters moved" << std::endl;
+    std::cout << "  Extents: " << result.extents_before << " -> " << result.extents_after << std::endl;
+    std::cout << "  Seeks reading in load order: " << result.seeks_before << " -> " << result.seeks_after
+              << std::endl;
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "DiskHandler.hpp"
+#include "DiskStats.hpp"
 #include "Fat12Driver.hpp"
 #include <iostream>
 #include <iomanip>
@@ -6,8 +7,9 @@
 using namespace libste;
 
 int main(int argc, char* argv[]) {
+    StatsReport report(take_stats_flag(argc, argv));
     if (argc < 2) {
-        std::cout << "Usage: st-dir <filename.st>" << std::endl;
+        std::cout << "Usage: st-dir [--stats] <filename.st>" << std::endl;
         return 1;
     }
 
@@ -31,6 +33,8 @@ int main(int argc, char* argv[]) {
                       << " | " << f.size << " bytes" << std::endl;
         }
     }
+    std::cout << "--------------------------------------" << std::endl;
+    std::cout << fs.free_clusters() * Fat12Driver::CLUSTER_SIZE << " bytes free" << std::endl;
 
     return 0;
 }
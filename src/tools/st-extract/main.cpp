@@ -1,12 +1,14 @@
 #include "DiskHandler.hpp"
+#include "DiskStats.hpp"
 #include "Fat12Driver.hpp"
 #include <iostream>
 
 using namespace libste;
 
 int main(int argc, char* argv[]) {
+    StatsReport report(take_stats_flag(argc, argv));
     if (argc < 4) {
-        std::cout << "Usage: st-extract <disk.st> <filename_on_disk> <local_dest_path>" << std::endl;
+        std::cout << "Usage: st-extract [--stats] <disk.st> <filename_on_disk> <local_dest_path>" << std::endl;
         std::cout << "Example: ./st-extract mydisk.st TEST.TXT restored.txt" << std::endl;
         return 1;
     }
@@ -1,12 +1,14 @@
 #include "DiskHandler.hpp"
+#include "DiskStats.hpp"
 #include "Fat12Driver.hpp"
 #include <iostream>
 
 using namespace libste;
 
 int main(int argc, char* argv[]) {
+    StatsReport report(take_stats_flag(argc, argv));
     if (argc < 4) {
-        std::cout << "Usage: st-inject <disk.st> <local_file> <target_name_on_disk>" << std::endl;
+        std::cout << "Usage: st-inject [--stats] <disk.st> <local_file> <target_name_on_disk>" << std::endl;
         std::cout << "Example: ./st-inject mydisk.st hello.prg HELLO.PRG" << std::endl;
         return 1;
     }
@@ -21,10 +23,17 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    std::string name;
+    if (!to_83(target_name, name)) {
+        std::cerr << "Error: " << target_name << " is not a valid 8.3 name." << std::endl;
+        return 1;
+    }
+
     Fat12Driver fs(disk);
-    std::cout << "Injecting " << local_path << " as " << target_name << "..." << std::endl;
+    std::cout << "Injecting " << local_path << " as " << name << "..." << std::endl;
 
     if (fs.inject_file(local_path, target_name)) {
+        fs.flush();
         if (disk.save_to_file(disk_path)) {
             std::cout << "Successfully injected and saved to disk!" << std::endl;
         } else {
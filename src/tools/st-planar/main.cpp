@@ -1,55 +1,194 @@
+#include "Planar.hpp"
+#include "BufferStore.hpp"
 #include <iostream>
 #include <vector>
-#include <fstream>
+#include <memory>
+#include <string>
 #include <cstdint>
-#include <arpa/inet.h> // for htons (Big Endian conversion)
-
-void chunky_to_planar(const std::vector<uint8_t>& chunky, std::vector<uint8_t>& planar) {
-    // Atari Low Res: 320x200, 4 planes (16 colors)
-    // 16 pixels are grouped into 4 words (8 bytes)
-    for (size_t i = 0; i < chunky.size(); i += 16) {
-        uint16_t planes[4] = {0, 0, 0, 0};
-
-        for (int p = 0; p < 16; ++p) {
-            uint8_t color_index = chunky[i + p] & 0x0F;
-            for (int b = 0; b < 4; ++b) {
-                if (color_index & (1 << b)) {
-                    // Atari bits are high-to-low within the word
-                    planes[b] |= (1 << (15 - p));
-                }
-            }
+#include <algorithm>
+
+using namespace libste;
+
+// Far beyond any ST screen or sprite, small enough that sizes can't overflow
+constexpr size_t kMaxDimension = 1 << 16;
+
+static void print_usage() {
+    std::cout << "Usage: st-planar [options] <input.chunky> <output.bin>\n";
+    std::cout << "Options:\n";
+    std::cout << "  --layout low|med|high  4, 2 or 1 interleaved planes (default: low)\n";
+    std::cout << "  --planes <n>           Plane count 1-8\n";
+    std::cout << "  --width <pixels>       Row width (default: whole input as one row)\n";
+    std::cout << "  --stride <bytes>       Output bytes per row (per plane row with --plane-major, 0 = packed)\n";
+    std::cout << "  --plane-major          Store each plane as a separate bitmap\n";
+    std::cout << "  --preshift <height>    Sprite bank: 16 pre-shifted copies + AND mask per\n";
+    std::cout << "                         width x height frame (requires --width)\n";
+    std::cout << "  --mask-separate        With --preshift, write the mask after the planes\n";
+    std::cout << "  --stream               Convert in fixed-size blocks with constant memory\n";
+    std::cout << "                         ('-' reads stdin / writes stdout)\n";
+    std::cout << "  --height <rows>        With --stream, rows per frame (required for --plane-major)\n";
+}
+
+// Decimal option value in min..max; prints the error otherwise
+static bool parse_count(const std::string& option, const std::string& text, size_t min, size_t max, size_t& value) {
+    if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos ||
+        std::stoul(text) < min || std::stoul(text) > max) {
+        std::cerr << "Error: " << option << " takes a number from " << min << " to " << max << ", not " << text << "\n";
+        return false;
+    }
+    value = std::stoul(text);
+    return true;
+}
+
+static int write_sprite_bank(std::span<const uint8_t> chunky, const SpriteFormat& format, const std::string& out_path) {
+    size_t frame_pixels = format.width * format.height;
+    size_t frames = frame_pixels ? chunky.size() / frame_pixels : 0;
+    if (frames == 0 || chunky.size() % frame_pixels != 0) {
+        std::cerr << "Error: Input is not a whole number of " << format.width << "x" << format.height << " frames.\n";
+        return 1;
+    }
+
+    std::vector<uint8_t> bank(frames * format.frame_size());
+    for (size_t f = 0; f < frames; ++f) {
+        auto src = chunky.subspan(f * frame_pixels, frame_pixels);
+        auto dst = std::span<uint8_t>(bank).subspan(f * format.frame_size(), format.frame_size());
+        if (!preshift_sprite(src, dst, format)) {
+            std::cerr << "Error: Invalid sprite format.\n";
+            return 1;
         }
+    }
+
+    if (!save_output(out_path, bank)) {
+        std::cerr << "Error: Could not write " << out_path << "\n";
+        return 1;
+    }
 
-        // Write the 4 words in order (Plane 0, 1, 2, 3)
-        for (int b = 0; b < 4; ++b) {
-            uint16_t be_word = htons(planes[b]); // Atari is Big Endian
-            uint8_t* ptr = reinterpret_cast<uint8_t*>(&be_word);
-            planar.push_back(ptr[0]);
-            planar.push_back(ptr[1]);
+    std::cout << "Pre-shifted " << frames << " frame(s) to " << bank.size() << " bytes ("
+              << format.shift_size() << " bytes per shift).\n";
+    return 0;
+}
+
+static int stream_convert(const PlaneLayout& layout, size_t frame_height, const std::string& in_path, const std::string& out_path) {
+    if (!layout.interleaved && frame_height == 0) {
+        std::cerr << "Error: --stream with --plane-major needs --height.\n";
+        return 1;
+    }
+
+    std::unique_ptr<std::istream> ifs;
+    std::unique_ptr<std::ostream> ofs;
+    if (in_path != "-") {
+        ifs = open_input_stream(in_path);
+        if (!ifs) {
+            std::cerr << "Error: Could not open " << in_path << "\n";
+            return 1;
         }
     }
+    if (out_path != "-") {
+        ofs = open_output_stream(out_path);
+        if (!ofs) {
+            std::cerr << "Error: Could not create " << out_path << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = (in_path == "-") ? std::cin : *ifs;
+    std::ostream& out = (out_path == "-") ? std::cout : *ofs;
+
+    // A block is one frame, or roughly 1 MB of whole rows
+    constexpr size_t kBlockPixels = 1 << 20;
+    size_t block_rows = frame_height ? frame_height : std::max<size_t>(1, kBlockPixels / layout.width);
+
+    uint64_t pixels = 0, bytes = 0;
+    if (!stream_chunky_to_planar(in, out, layout, block_rows, pixels, bytes)) {
+        std::cerr << "Error: Streaming conversion failed.\n";
+        return 1;
+    }
+    std::cerr << "Converted " << pixels << " chunky pixels to " << bytes << " bytes of planar data.\n";
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cout << "Usage: st-planar <input.chunky> <output.bin>\n";
+    PlaneLayout layout = kLowRes;
+    bool width_given = false;
+    bool streaming = false;
+    size_t frame_height = 0;
+    size_t sprite_height = 0;
+    MaskPlacement mask = MaskPlacement::Interleaved;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--layout" && has_value) {
+            std::string v = argv[++i];
+            if (v == "low") layout = kLowRes;
+            else if (v == "med") layout = kMediumRes;
+            else if (v == "high") layout = kHighRes;
+            else { std::cerr << "Error: Unknown layout " << v << "\n"; return 1; }
+        } else if (arg == "--planes" && has_value) {
+            size_t planes;
+            if (!parse_count(arg, argv[++i], 1, 8, planes)) return 1;
+            layout.planes = static_cast<int>(planes);
+        } else if (arg == "--width" && has_value) {
+            if (!parse_count(arg, argv[++i], 1, kMaxDimension, layout.width)) return 1;
+            width_given = true;
+        } else if (arg == "--stride" && has_value) {
+            if (!parse_count(arg, argv[++i], 0, kMaxDimension, layout.row_stride)) return 1;
+        } else if (arg == "--plane-major") {
+            layout.interleaved = false;
+        } else if (arg == "--preshift" && has_value) {
+            if (!parse_count(arg, argv[++i], 1, kMaxDimension, sprite_height)) return 1;
+        } else if (arg == "--mask-separate") {
+            mask = MaskPlacement::Separate;
+        } else if (arg == "--stream") {
+            streaming = true;
+        } else if (arg == "--height" && has_value) {
+            if (!parse_count(arg, argv[++i], 1, kMaxDimension, frame_height)) return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.size() < 2) {
+        print_usage();
         return 1;
     }
 
-    std::ifstream ifs(argv[1], std::ios::binary);
-    std::vector<uint8_t> chunky((std::istreambuf_iterator<char>(ifs)), 
-                                 std::istreambuf_iterator<char>());
+    if (streaming && !sprite_height) {
+        // Interleaved rows are independent, so 16-pixel rows give the same output
+        if (!width_given) layout.width = 16;
+        return stream_convert(layout, frame_height, paths[0], paths[1]);
+    }
+
+    std::vector<uint8_t> storage;
+    std::span<const uint8_t> chunky;
+    if (!load_input(paths[0], storage, chunky)) {
+        std::cerr << "Error: Could not open " << paths[0] << "\n";
+        return 1;
+    }
+
+    if (sprite_height) {
+        if (!width_given) {
+            std::cerr << "Error: --preshift needs --width.\n";
+            return 1;
+        }
+        return write_sprite_bank(chunky, SpriteFormat{ layout.width, sprite_height, layout.planes, mask }, paths[1]);
+    }
 
     if (chunky.size() % 16 != 0) {
         std::cerr << "Warning: Input size not multiple of 16. Padding with zeros.\n";
-        while (chunky.size() % 16 != 0) chunky.push_back(0);
     }
+    // Interleaved output without an explicit width is one continuous row
+    if (!width_given) layout.width = chunky.empty() ? 16 : chunky.size();
 
     std::vector<uint8_t> planar;
-    chunky_to_planar(chunky, planar);
+    if (!chunky_to_planar(chunky, planar, layout)) {
+        std::cerr << "Error: Invalid plane layout.\n";
+        return 1;
+    }
 
-    std::ofstream ofs(argv[2], std::ios::binary);
-    ofs.write(reinterpret_cast<const char*>(planar.data()), planar.size());
+    if (!save_output(paths[1], planar)) {
+        std::cerr << "Error: Could not write " << paths[1] << "\n";
+        return 1;
+    }
 
     std::cout << "Converted " << chunky.size() << " chunky pixels to " 
               << planar.size() << " bytes of planar data.\n";
@@ -0,0 +1,33 @@
+#include "DiskHandler.hpp"
+#include "DiskStats.hpp"
+#include "Fat12Driver.hpp"
+#include <iostream>
+
+using namespace libste;
+
+int main(int argc, char* argv[]) {
+    StatsReport report(take_stats_flag(argc, argv));
+    if (argc < 4) {
+        std::cout << "Usage: st-ren [--stats] <disk.st> <old_name> <new_name>" << std::endl;
+        return 1;
+    }
+
+    std::string disk_path = argv[1];
+    DiskHandler disk;
+    if (!disk.load_from_file(disk_path)) {
+        std::cerr << "Error: Could not open disk image: " << disk_path << std::endl;
+        return 1;
+    }
+
+    Fat12Driver fs(disk);
+    if (!fs.rename_file(argv[2], argv[3])) {
+        std::cerr << "Error: Rename failed (" << argv[2] << " not found, or " << argv[3] << " taken or not a valid 8.3 name)." << std::endl;
+        return 1;
+    }
+    if (!disk.save_to_file(disk_path)) {
+        std::cerr << "Error: Could not save changes to disk image." << std::endl;
+        return 1;
+    }
+    std::cout << "Renamed " << argv[2] << " to " << argv[3] << std::endl;
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include "DiskHandler.hpp"
+#include "DiskStats.hpp"
+#include "Fat12Driver.hpp"
+#include <iostream>
+
+using namespace libste;
+
+int main(int argc, char* argv[]) {
+    StatsReport report(take_stats_flag(argc, argv));
+    if (argc < 3) {
+        std::cout << "Usage: st-rm [--stats] <disk.st> <name_on_disk>..." << std::endl;
+        return 1;
+    }
+
+    std::string disk_path = argv[1];
+    DiskHandler disk;
+    if (!disk.load_from_file(disk_path)) {
+        std::cerr << "Error: Could not open disk image: " << disk_path << std::endl;
+        return 1;
+    }
+
+    Fat12Driver fs(disk);
+    int status = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (fs.delete_file(argv[i])) {
+            std::cout << "Deleted " << argv[i] << std::endl;
+        } else {
+            std::cerr << "Error: " << argv[i] << " not found, a directory, or not a valid 8.3 name." << std::endl;
+            status = 1;
+        }
+    }
+    std::cout << fs.free_clusters() * Fat12Driver::CLUSTER_SIZE << " bytes free" << std::endl;
+    fs.flush();
+
+    if (!disk.save_to_file(disk_path)) {
+        std::cerr << "Error: Could not save changes to disk image." << std::endl;
+        return 1;
+    }
+    return status;
+}
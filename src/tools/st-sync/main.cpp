@@ -0,0 +1,84 @@
+#include "DiskHandler.hpp"
+#include "BufferStore.hpp"
+#include "DiskStats.hpp"
+#include "DiskSync.hpp"
+#include "Fat12Driver.hpp"
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace libste;
+
+static void usage() {
+    std::cout << "Usage: st-sync [--stats] <host_dir> <disk.st>" << std::endl;
+    std::cout << "       st-sync [--stats] --extract [--jobs n] <disk.st> <host_dir>" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    StatsReport report(take_stats_flag(argc, argv));
+
+    bool extract = false;
+    unsigned jobs = 0;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--extract") {
+            extract = true;
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            // 0 = one per core
+            std::string value = argv[++i];
+            if (value.empty() || value.size() > 3 || value.find_first_not_of("0123456789") != std::string::npos ||
+                std::stoul(value) > 256) {
+                std::cerr << "Error: --jobs takes a thread count from 0 to 256, not " << value << std::endl;
+                return 1;
+            }
+            jobs = static_cast<unsigned>(std::stoul(value));
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != 2) {
+        usage();
+        return 1;
+    }
+
+    SyncResult result;
+    std::string error;
+    DiskHandler disk;
+    if (extract) {
+        if (!disk.load_from_file(paths[0])) {
+            std::cerr << "Error: Could not open disk image: " << paths[0] << std::endl;
+            return 1;
+        }
+        if (!extract_to_tree(disk, paths[1], jobs, result, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        std::cout << "Extracted " << result.files << " files, " << result.directories << " directories ("
+                  << result.bytes << " bytes) to " << paths[1] << std::endl;
+        return 0;
+    }
+
+    // Update an existing image in place (keeping its boot sector), or start a new one
+    const std::string& disk_path = paths[1];
+    bool existing = is_buffer_path(disk_path) || std::filesystem::exists(disk_path);
+    if (existing ? !disk.load_from_file(disk_path) : !disk.create_blank()) {
+        std::cerr << "Error: Could not open disk image: " << disk_path << std::endl;
+        return 1;
+    }
+    if (!existing) disk.apply_tos_checksum();  // As st-mkdisk does
+
+    if (!build_from_tree(disk, paths[0], result, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+    if (!disk.save_to_file(disk_path)) {
+        std::cerr << "Error: Could not save " << disk_path << std::endl;
+        return 1;
+    }
+    std::cout << (existing ? "Updated " : "Created ") << disk_path << ": " << result.files << " files, "
+              << result.directories << " directories, " << result.bytes << " bytes in " << result.clusters
+              << " of " << Fat12Driver(disk).cluster_limit() - 2 << " clusters" << std::endl;
+    return 0;
+}
@@ -1,8 +1,18 @@
+#include "Resampler.hpp"
+#include "AudioReader.hpp"
+#include "Pcm.hpp"
+#include "ModFile.hpp"
+#include "ModPlayer.hpp"
+#include "BufferStore.hpp"
 #include <iostream>
 #include <vector>
-#include <fstream>
 #include <cstdint>
 #include <string>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace libste;
 
 // The Atari STE DMA chip supports 4 specific frequencies:
 // 0: 6258 Hz
@@ -10,41 +20,365 @@
 // 2: 25033 Hz
 // 3: 50066 Hz
 
-int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cout << "Usage: ste-dma-snd <input_raw_unsigned> <output_ste_signed>\n";
-        std::cout << "Note: Input should be 8-bit raw mono data.\n";
+struct Options {
+    uint32_t in_rate = 0;
+    uint32_t out_rate = kSteDmaRates[3];
+    bool dither = false;
+    bool stereo = false;
+    size_t align = 0;
+    bool in_place = false;
+};
+
+static void print_usage() {
+    std::cout << "Usage: ste-dma-snd [options] <input_raw_unsigned> <output_ste_signed>\n";
+    std::cout << "       ste-dma-snd --in-place <raw_file>\n";
+    std::cout << "Options:\n";
+    std::cout << "  --from <Hz>      Sample rate of raw input; enables resampling\n";
+    std::cout << "  --rate <0-3|Hz>  Target STE DMA rate (default: 3 = 50066 Hz)\n";
+    std::cout << "  --dither         TPDF dither when requantizing to 8 bits\n";
+    std::cout << "  --stereo         Interleaved L/R output (raw input is read as L/R pairs)\n";
+    std::cout << "  --align <bytes>  Pad the output with silence to a multiple of <bytes>\n";
+    std::cout << "                   (2 = DMA word alignment for the start/end registers;\n";
+    std::cout << "                   must be even with --stereo)\n";
+    std::cout << "Note: Input is 8-bit raw data, or a WAV/AIFF file (8/16/24-bit,\n";
+    std::cout << "      any channel count and rate) which is remixed and resampled,\n";
+    std::cout << "      or a ProTracker MOD which is rendered at the target rate.\n";
+}
+
+static bool parse_ste_rate(const std::string& text, uint32_t& rate) {
+    if (text.empty() || text.size() > 5 || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    uint32_t value = static_cast<uint32_t>(std::stoul(text));
+    if (value < 4) {
+        rate = kSteDmaRates[value];
+        return true;
+    }
+    for (uint32_t r : kSteDmaRates) {
+        if (r == value) { rate = r; return true; }
+    }
+    return false;
+}
+
+// Resamples and requantizes one or two float channels into STE signed PCM
+class DmaEncoder {
+public:
+    DmaEncoder(uint32_t in_rate, const Options& opt) : opt_(opt) {
+        channels_ = opt.stereo ? 2 : 1;
+        if (in_rate != opt.out_rate) {
+            for (int c = 0; c < channels_; ++c) resamplers_[c] = std::make_unique<Resampler>(in_rate, opt.out_rate);
+        }
+    }
+
+    // `planes` holds `channels_` channel blocks of equal length
+    void push(std::span<const float> planes[2], std::ostream& out) {
+        encode(planes, false, out);
+    }
+
+    void finish(std::ostream& out) {
+        std::span<const float> empty[2];
+        if (resamplers_[0]) encode(empty, true, out);
+        size_t padded = dma_aligned_size(bytes_, opt_.align);
+        std::vector<uint8_t> silence(padded - bytes_, 0);
+        out.write(reinterpret_cast<const char*>(silence.data()), silence.size());
+        bytes_ = padded;
+    }
+
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    const Options& opt_;
+    int channels_;
+    std::unique_ptr<Resampler> resamplers_[2];
+    std::vector<float> resampled_[2];
+    std::vector<uint8_t> pcm_[2], frames_;
+    uint32_t seed_ = 0x5354450A;
+    uint64_t bytes_ = 0;
+
+    void encode(std::span<const float> planes[2], bool flush, std::ostream& out) {
+        size_t n = SIZE_MAX;
+        for (int c = 0; c < channels_; ++c) {
+            std::span<const float> samples = planes[c];
+            if (resamplers_[c]) {
+                resampled_[c].clear();
+                if (flush) resamplers_[c]->flush(resampled_[c]);
+                else resamplers_[c]->process(samples, resampled_[c]);
+                samples = resampled_[c];
+            }
+            pcm_[c].resize(samples.size());
+            quantize_to_s8(samples, pcm_[c], opt_.dither, seed_);
+            n = std::min(n, samples.size());
+        }
+
+        const uint8_t* data = pcm_[0].data();
+        size_t size = n;
+        if (channels_ == 2) {
+            frames_.resize(n * 2);
+            interleave_stereo<uint8_t>(std::span(pcm_[0]).first(n), std::span(pcm_[1]).first(n), frames_);
+            data = frames_.data();
+            size = frames_.size();
+        }
+        out.write(reinterpret_cast<const char*>(data), size);
+        bytes_ += size;
+    }
+};
+
+// Single pass: decode a block, remix, resample, requantize, write
+static int convert_audio_file(const std::string& in_path, const std::string& out_path, const Options& opt) {
+    AudioReader reader;
+    if (!reader.open(in_path)) {
+        std::cerr << "Error: Unsupported or corrupt WAV/AIFF file.\n";
         return 1;
     }
+    const AudioFormat& fmt = reader.format();
 
-    std::ifstream ifs(argv[1], std::ios::binary | std::ios::ate);
-    if (!ifs) {
-        std::cerr << "Error: Could not open input file.\n";
+    auto out = open_output_stream(out_path);
+    if (!out) {
+        std::cerr << "Error: Could not create output file.\n";
         return 1;
     }
+    std::ostream& ofs = *out;
 
-    std::streamsize size = ifs.tellg();
-    ifs.seekg(0, std::ios::beg);
+    constexpr size_t kBlockFrames = 16384;
+    std::vector<float> block(kBlockFrames * fmt.channels), left(kBlockFrames), right(kBlockFrames);
+    DmaEncoder encoder(fmt.sample_rate, opt);
+    uint64_t frames_in = 0;
+
+    while (true) {
+        size_t frames;
+        std::span<const float> planes[2];
+        if (!opt.stereo) {
+            frames = reader.read_mono(std::span(block).first(kBlockFrames));
+            planes[0] = std::span<const float>(block.data(), frames);
+        } else if (fmt.channels == 2) {
+            frames = reader.read(block);
+            deinterleave_stereo<float>(std::span<const float>(block.data(), frames * 2), left, right);
+            planes[0] = std::span<const float>(left.data(), frames);
+            planes[1] = std::span<const float>(right.data(), frames);
+        } else {
+            // Mono sources go to both sides; extra channels beyond L/R are dropped
+            frames = reader.read(block);
+            for (size_t f = 0; f < frames; ++f) {
+                left[f] = block[f * fmt.channels];
+                right[f] = block[f * fmt.channels + (fmt.channels > 1 ? 1 : 0)];
+            }
+            planes[0] = std::span<const float>(left.data(), frames);
+            planes[1] = std::span<const float>(right.data(), frames);
+        }
+        if (frames == 0) break;
+        frames_in += frames;
+        encoder.push(planes, ofs);
+    }
+    encoder.finish(ofs);
 
-    std::vector<uint8_t> buffer(size);
-    if (!ifs.read(reinterpret_cast<char*>(buffer.data()), size)) {
-        std::cerr << "Error reading file.\n";
+    if (!ofs) {
+        std::cerr << "Error: Could not write output file.\n";
+        return 1;
+    }
+    std::cout << "Decoded " << frames_in << " frames (" << fmt.bits_per_sample << "-bit, "
+              << fmt.channels << " ch, " << fmt.sample_rate << " Hz) to " << encoder.bytes()
+              << " bytes of STE " << (opt.stereo ? "stereo" : "mono") << " PCM at " << opt.out_rate << " Hz.\n";
+    std::cout << "Hardware Tip: Set $FF8901 to enable DMA playback.\n";
+    return 0;
+}
+
+// Renders a MOD straight at the DMA rate, one replay tick at a time
+static int convert_mod_file(const std::string& in_path, const std::string& out_path, const Options& opt) {
+    ModSong song;
+    if (!load_mod_file(in_path, song)) {
+        std::cerr << "Error: Unsupported or corrupt MOD file.\n";
         return 1;
     }
 
-    // Convert Unsigned 8-bit (0 to 255) to Signed 8-bit (-128 to 127)
-    // The STE DMA hardware expects signed data.
-    // Logic: subtract 128 from the unsigned value.
-    for (size_t i = 0; i < buffer.size(); ++i) {
-        int signed_val = static_cast<int>(buffer[i]) - 128;
-        buffer[i] = static_cast<int8_t>(signed_val);
+    auto out = open_output_stream(out_path);
+    if (!out) {
+        std::cerr << "Error: Could not create output file.\n";
+        return 1;
     }
+    std::ostream& ofs = *out;
 
-    std::ofstream ofs(argv[2], std::ios::binary);
-    ofs.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    constexpr size_t kBlockFrames = 16384;
+    ModPlayer player(song, opt.out_rate);
+    DmaEncoder encoder(opt.out_rate, opt);
+    std::vector<float> left, right;
+    left.reserve(kBlockFrames * 2);
+    right.reserve(kBlockFrames * 2);
+    uint64_t frames_out = 0;
 
-    std::cout << "Converted " << size << " samples to STE signed format.\n";
-    std::cout << "Hardware Tip: Set \$FF8901 to enable DMA playback.\n";
+    auto flush = [&] {
+        if (!opt.stereo) {
+            for (size_t i = 0; i < left.size(); ++i) left[i] = (left[i] + right[i]) * 0.5f;
+        }
+        std::span<const float> planes[2] = { left, right };
+        encoder.push(planes, ofs);
+        frames_out += left.size();
+        left.clear();
+        right.clear();
+    };
+    while (player.render_tick(left, right)) {
+        if (left.size() >= kBlockFrames) flush();
+    }
+    flush();
+    encoder.finish(ofs);
 
+    if (!ofs) {
+        std::cerr << "Error: Could not write output file.\n";
+        return 1;
+    }
+    std::cout << "Rendered \"" << song.title << "\" (" << song.channels << " channels, " << frames_out
+              << " frames) to " << encoder.bytes() << " bytes of STE " << (opt.stereo ? "stereo" : "mono")
+              << " PCM at " << opt.out_rate << " Hz.\n";
+    std::cout << "Hardware Tip: Set $FF8901 to enable DMA playback.\n";
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--from" && has_value) {
+            char* end = nullptr;
+            unsigned long rate = std::strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || rate == 0 || rate > 384000) {
+                std::cerr << "Error: --from needs a sample rate in Hz (1 to 384000).\n";
+                return 1;
+            }
+            opt.in_rate = static_cast<uint32_t>(rate);
+        } else if (arg == "--rate" && has_value) {
+            if (!parse_ste_rate(argv[++i], opt.out_rate)) {
+                std::cerr << "Error: Rate must be 0-3 or one of 6258, 12517, 25033, 50066.\n";
+                return 1;
+            }
+        } else if (arg == "--dither") {
+            opt.dither = true;
+        } else if (arg == "--stereo") {
+            opt.stereo = true;
+        } else if (arg == "--in-place") {
+            opt.in_place = true;
+        } else if (arg == "--align" && has_value) {
+            char* end = nullptr;
+            unsigned long align = std::strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || argv[i][0] == '-' || align == 0 || align > 65536) {
+                std::cerr << "Error: --align needs a byte count from 1 to 65536.\n";
+                return 1;
+            }
+            opt.align = align;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    // Padding must not stop partway through an L/R frame
+    if (opt.stereo && opt.align % 2 != 0) {
+        std::cerr << "Error: --align must be a multiple of 2 (one L/R frame) with --stereo.\n";
+        return 1;
+    }
+
+    if (opt.in_rate && !Resampler::supports(opt.in_rate, opt.out_rate)) {
+        std::cerr << "Error: " << opt.in_rate << " Hz is too far from the DMA rate to resample.\n";
+        return 1;
+    }
+
+    if (opt.in_place && paths.size() == 1) {
+        // Flipping every byte would wreck a header along with the samples
+        if (AudioReader::is_audio_file(paths[0]) || is_mod_file(paths[0])) {
+            std::cerr << "Error: " << paths[0] << " is a WAV/AIFF/MOD file, not raw samples; "
+                      << "convert it with ste-dma-snd <input> <output.snd> instead.\n";
+            return 1;
+        }
+        // Raw unsigned -> signed inside the file itself (mmap, no copy)
+        if (!flip_pcm_sign_file(paths[0])) {
+            std::cerr << "Error: Could not convert " << paths[0] << " in place.\n";
+            return 1;
+        }
+        std::cout << "Converted " << paths[0] << " to STE signed format in place.\n";
+        return 0;
+    }
+
+    if (paths.size() < 2) {
+        print_usage();
+        return 1;
+    }
+
+    if (paths[0] != "-" && is_mod_file(paths[0])) {
+        return convert_mod_file(paths[0], paths[1], opt);
+    }
+    if (paths[0] == "-" || AudioReader::is_audio_file(paths[0])) {
+        return convert_audio_file(paths[0], paths[1], opt);
+    }
+
+    auto in = open_input_stream(paths[0]);
+    if (!in) {
+        std::cerr << "Error: Could not open input file.\n";
+        return 1;
+    }
+    std::istream& ifs = *in;
+    std::streamsize size = ifs.seekg(0, std::ios::end).tellg();
+    ifs.seekg(0, std::ios::beg);
+    if (opt.stereo && size % 2 != 0) {
+        std::cerr << "Warning: Odd byte count in stereo input, dropping the last byte.\n";
+        --size;
+    }
+
+    auto out = open_output_stream(paths[1]);
+    if (!out) {
+        std::cerr << "Error: Could not create output file.\n";
+        return 1;
+    }
+    std::ostream& ofs = *out;
+    if (opt.in_rate) {
+        // Resample to the exact DMA rate, then requantize to signed 8-bit,
+        // one fixed block at a time like the WAV/AIFF path
+        constexpr size_t kBlockFrames = 16384;
+        size_t channels = opt.stereo ? 2 : 1;
+        uint64_t frames = static_cast<uint64_t>(size) / channels;
+        std::vector<uint8_t> block(kBlockFrames * channels);
+        std::vector<float> left(kBlockFrames), right(opt.stereo ? kBlockFrames : 0);
+        DmaEncoder encoder(opt.in_rate, opt);
+        for (uint64_t remaining = frames; remaining > 0;) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, kBlockFrames));
+            if (!ifs.read(reinterpret_cast<char*>(block.data()), n * channels)) {
+                std::cerr << "Error reading file.\n";
+                return 1;
+            }
+            for (size_t f = 0; f < n; ++f) {
+                left[f] = (static_cast<int>(block[f * channels]) - 128) / 128.0f;
+                if (opt.stereo) right[f] = (static_cast<int>(block[f * 2 + 1]) - 128) / 128.0f;
+            }
+            std::span<const float> planes[2] = { std::span<const float>(left).first(n),
+                                                 std::span<const float>(right).first(opt.stereo ? n : 0) };
+            encoder.push(planes, ofs);
+            remaining -= n;
+        }
+        encoder.finish(ofs);
+        std::cout << "Resampled " << frames << " frames at " << opt.in_rate << " Hz to "
+                  << encoder.bytes() << " bytes at " << opt.out_rate << " Hz.\n";
+    } else {
+        // Convert Unsigned 8-bit (0 to 255) to Signed 8-bit (-128 to 127)
+        // The STE DMA hardware expects signed data; interleaved stereo converts the same way.
+        // Streamed through one fixed block so the file is never held in memory.
+        constexpr size_t kBlockSize = 1 << 20;
+        std::vector<uint8_t> block(kBlockSize);
+        uint64_t remaining = static_cast<uint64_t>(size);
+        while (remaining > 0) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, kBlockSize));
+            if (!ifs.read(reinterpret_cast<char*>(block.data()), n)) {
+                std::cerr << "Error reading file.\n";
+                return 1;
+            }
+            flip_pcm_sign(std::span<uint8_t>(block.data(), n));
+            ofs.write(reinterpret_cast<const char*>(block.data()), n);
+            remaining -= n;
+        }
+        size_t padded = dma_aligned_size(static_cast<size_t>(size), opt.align);
+        std::vector<uint8_t> silence(padded - static_cast<size_t>(size), 0);
+        ofs.write(reinterpret_cast<const char*>(silence.data()), silence.size());
+        std::cout << "Converted " << size << " samples to STE signed format";
+        if (padded > static_cast<size_t>(size)) std::cout << " (+" << padded - size << " bytes of padding)";
+        std::cout << ".\n";
+    }
+    std::cout << "Hardware Tip: Set $FF8901 to enable DMA playback.\n";
+
+    return ofs ? 0 : 1;
+}
@@ -1,52 +1,129 @@
+#include "StePalette.hpp"
+#include "ColorMatcher.hpp"
+#include "BufferStore.hpp"
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <iomanip>
 
-// Helper to convert a 0-15 value to the weird Atari STE bit order:
-// Atari STE bit 3 is actually moved to the position of bit 0.
-// Expected order in nibble: [Bit 3] [Bit 0] [Bit 1] [Bit 2]
-uint8_t to_ste_nibble(uint8_t value) {
-    value &= 0x0F;
-    uint8_t bit3 = (value >> 3) & 0x01;
-    uint8_t bits012 = value & 0x07;
-    return (bits012 << 1) | bit3;
+using namespace libste;
+
+static void print_usage() {
+    std::cout << "Usage: ste-palette <hex_color>\n";
+    std::cout << "       ste-palette --batch [--perceptual] [--in auto|hex|gpl|pal] [--emit hex|asm|c] [--name sym] [file|-]\n";
+    std::cout << "       ste-palette --reverse [--emit hex|gpl] [--name sym] [file|-]\n";
+    std::cout << "Example: ste-palette #FF8800\n";
+    std::cout << "         ste-palette --batch --emit asm title.gpl\n";
+}
+
+static bool read_input(const std::string& path, std::string& text) {
+    std::ostringstream ss;
+    if (path == "-") {
+        ss << std::cin.rdbuf();
+    } else {
+        auto in = open_input_stream(path);
+        if (!in) return false;
+        ss << in->rdbuf();
+    }
+    text = ss.str();
+    return true;
+}
+
+static int run_batch(int argc, char* argv[], bool reverse) {
+    PaletteFormat in_format = PaletteFormat::Auto;
+    PaletteEmit emit = PaletteEmit::Hex;
+    std::string name;
+    std::string path = "-";
+    bool perceptual = false;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value = (i + 1 < argc) ? argv[i + 1] : "";
+        if (arg == "--in") {
+            if (value == "hex") in_format = PaletteFormat::Hex;
+            else if (value == "gpl") in_format = PaletteFormat::Gimp;
+            else if (value == "pal") in_format = PaletteFormat::Jasc;
+            else if (value != "auto") { std::cerr << "Error: Unknown input format " << value << "\n"; return 1; }
+            ++i;
+        } else if (arg == "--emit") {
+            if (value == "hex") emit = PaletteEmit::Hex;
+            else if (value == "asm" && !reverse) emit = PaletteEmit::Asm;
+            else if (value == "c" && !reverse) emit = PaletteEmit::CArray;
+            else if (value == "gpl" && reverse) emit = PaletteEmit::Gimp;
+            else { std::cerr << "Error: Unknown output style " << value << "\n"; return 1; }
+            ++i;
+        } else if (arg == "--perceptual") {
+            perceptual = true;
+        } else if (arg == "--name") {
+            name = value;
+            ++i;
+        } else {
+            path = arg;
+        }
+    }
+
+    std::string text;
+    if (!read_input(path, text)) {
+        std::cerr << "Error: Could not open " << path << "\n";
+        return 1;
+    }
+
+    std::string out;
+    if (reverse) {
+        std::vector<uint16_t> words;
+        if (!read_ste_words(text, words)) {
+            std::cerr << "Error: Malformed STE word list in " << path << "\n";
+            return 1;
+        }
+        emit_rgb_palette(ste_to_palette(words), emit, name, out);
+    } else {
+        std::vector<Rgb8> colors;
+        if (!read_palette(text, in_format, colors)) {
+            std::cerr << "Error: Malformed palette in " << path << "\n";
+            return 1;
+        }
+        std::vector<uint16_t> words;
+        if (perceptual) {
+            // Closest STE colour by delta E instead of per-channel rounding
+            const auto& matcher = ColorMatcher::instance();
+            for (const auto& c : colors) words.push_back(matcher.nearest_exact(c));
+        } else {
+            words = palette_to_ste(colors);
+        }
+        emit_ste_words(words, emit, name, out);
+    }
+
+    std::cout.write(out.data(), out.size());
+    return std::cout.good() ? 0 : 1;
 }
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cout << "Usage: ste-palette <hex_color>\n";
-        std::cout << "Example: ste-palette #FF8800\n";
+        print_usage();
         return 1;
     }
 
-    std::string hex = argv[1];
-    if (hex[0] == '#') hex.erase(0, 1);
+    std::string mode = argv[1];
+    if (mode == "--batch") return run_batch(argc, argv, false);
+    if (mode == "--reverse") return run_batch(argc, argv, true);
 
-    if (hex.length() != 6) {
+    std::string hex = argv[1];
+    Rgb8 color;
+    if (!parse_hex_rgb(hex, color)) {
         std::cerr << "Error: Provide a 6-digit hex color (RRGGBB).\n";
         return 1;
     }
 
-    // Extract 8-bit components
-    uint8_t r8 = std::stoi(hex.substr(0, 2), nullptr, 16);
-    uint8_t g8 = std::stoi(hex.substr(2, 2), nullptr, 16);
-    uint8_t b8 = std::stoi(hex.substr(4, 2), nullptr, 16);
-
-    // Downsample to 4-bit (0-15)
-    uint8_t r4 = r8 >> 4;
-    uint8_t g4 = g8 >> 4;
-    uint8_t b4 = b8 >> 4;
-
-    // Convert to STE nibble format
-    uint16_t ste_r = to_ste_nibble(r4);
-    uint16_t ste_g = to_ste_nibble(g4);
-    uint16_t ste_b = to_ste_nibble(b4);
+    // Round to the nearest 4-bit STE level (0-15)
+    uint8_t r4 = round_to_ste_level(color.r);
+    uint8_t g4 = round_to_ste_level(color.g);
+    uint8_t b4 = round_to_ste_level(color.b);
 
-    // Combine into a 16-bit word (Atari format: 0RRR 0GGG 0BBB)
-    // Note: The high nibble is usually 0 in ST/STE palettes.
-    uint16_t palette_word = (ste_r << 8) | (ste_g << 4) | ste_b;
+    uint16_t palette_word = rgb_to_ste_word(color);
 
-    std::cout << "Input Hex: #" << hex << "\n";
+    // Normalised, whichever of #, $ or 0x the input used
+    uint32_t rgb = (uint32_t(color.r) << 16) | (color.g << 8) | color.b;
+    std::cout << "Input Hex: #" << std::hex << std::uppercase << std::setw(6) << std::setfill('0') << rgb << std::dec << "\n";
     std::cout << "STE 4-bit: R:" << (int)r4 << " G:" << (int)g4 << " B:" << (int)b4 << "\n";
     std::cout << "Atari Word: 0x" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << palette_word << "\n";
 
@@ -1,65 +1,88 @@
+#include "Pcm.hpp"
+#include "WavWriter.hpp"
+#include "BufferStore.hpp"
 #include <iostream>
-#include <fstream>
+#include <memory>
 #include <vector>
 #include <cstdint>
+#include <cstdlib>
 #include <string>
 
-// RIFF/WAV Header Structure
-#pragma pack(push, 1)
-struct WavHeader {
-    char riff[4] = {'R','I','F','F'};
-    uint32_t overall_size;
-    char wave[4] = {'W','A','V','E'};
-    char fmt_chunk_marker[4] = {'f','m','t',' '};
-    uint32_t length_of_fmt = 16;
-    uint16_t format_type = 1; // PCM
-    uint16_t channels = 1;    // Mono
-    uint32_t sample_rate;
-    uint32_t byte_rate;
-    uint16_t block_align = 1;
-    uint16_t bits_per_sample = 8;
-    char data_chunk_marker[4] = {'d','a','t','a'};
-    uint32_t data_size;
-};
-#pragma pack(pop)
+using namespace libste;
 
 int main(int argc, char* argv[]) {
-    if (argc < 4) {
-        std::cout << "Usage: ste-snd-wav <input.snd> <output.wav> <rate>\n";
+    bool stereo = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stereo") stereo = true;
+        else args.push_back(arg);
+    }
+
+    if (args.size() < 3) {
+        std::cout << "Usage: ste-snd-wav [--stereo] <input.snd|-> <output.wav|-> <rate>\n";
         std::cout << "Common STE Rates: 6258, 12517, 25033, 50066\n";
+        std::cout << "--stereo treats the input as interleaved L/R DMA frames.\n";
         return 1;
     }
 
-    std::ifstream ifs(argv[1], std::ios::binary | std::ios::ate);
-    if (!ifs) {
-        std::cerr << "Error: Could not open input file.\n";
+    char* end = nullptr;
+    unsigned long rate = std::strtoul(args[2].c_str(), &end, 10);
+    if (*end != '\0' || args[2][0] == '-' || rate < 1000 || rate > 192000) {
+        std::cerr << "Error: rate must be a sample rate in Hz (1000 to 192000).\n";
         return 1;
     }
-    
-    uint32_t data_size = ifs.tellg();
-    ifs.seekg(0, std::ios::beg);
 
-    std::vector<uint8_t> buffer(data_size);
-    ifs.read((char*)buffer.data(), data_size);
+    std::unique_ptr<std::istream> ifs;
+    if (args[0] != "-") {
+        ifs = open_input_stream(args[0]);
+        if (!ifs) {
+            std::cerr << "Error: Could not open input file.\n";
+            return 1;
+        }
+    }
+    std::istream& in = (args[0] == "-") ? std::cin : *ifs;
+
+    uint16_t channels = stereo ? 2 : 1;
+    WavWriter wav;
+    if (!wav.open(args[1], static_cast<uint32_t>(rate), channels, 8)) {
+        std::cerr << "Error: Could not create " << args[1] << "\n";
+        return 1;
+    }
 
     // Atari STE uses SIGNED 8-bit (-128 to 127). 
     // Standard WAV uses UNSIGNED 8-bit (0 to 255).
     // We must shift the data back for modern players.
-    for(auto &sample : buffer) {
-        sample = static_cast<uint8_t>(static_cast<int8_t>(sample) + 128);
-    }
+    // WAV stereo is interleaved L/R just like the STE, so frames map 1:1.
+    constexpr size_t kBlockSize = 1 << 20;
+    std::vector<uint8_t> block(kBlockSize);
+    uint8_t carry = 0;
+    bool has_carry = false;
+    while (true) {
+        size_t offset = has_carry ? 1 : 0;
+        if (has_carry) block[0] = carry;
+        size_t got = static_cast<size_t>(in.rdbuf()->sgetn(reinterpret_cast<char*>(block.data() + offset), kBlockSize - offset));
+        size_t n = offset + got;
+        if (got == 0) break;
+
+        // Keep stereo frames whole across block boundaries
+        has_carry = stereo && (n % 2 != 0);
+        if (has_carry) carry = block[--n];
 
-    uint32_t rate = std::stoi(argv[3]);
-    WavHeader header;
-    header.sample_rate = rate;
-    header.byte_rate = rate;
-    header.data_size = data_size;
-    header.overall_size = data_size + sizeof(WavHeader) - 8;
+        flip_pcm_sign(std::span<uint8_t>(block.data(), n));
+        if (!wav.write(std::span<const uint8_t>(block.data(), n))) break;
+    }
+    if (has_carry) {
+        std::cerr << "Warning: Odd byte count in stereo input, dropping the last byte.\n";
+    }
 
-    std::ofstream ofs(argv[2], std::ios::binary);
-    ofs.write((char*)&header, sizeof(WavHeader));
-    ofs.write((char*)buffer.data(), data_size);
+    uint64_t data_size = wav.data_bytes();
+    if (!wav.close()) {
+        std::cerr << "Error: Could not write " << args[1] << "\n";
+        return 1;
+    }
 
-    std::cout << "Successfully converted STE audio to " << argv[2] << " (" << rate << "Hz)\n";
+    std::cerr << "Successfully converted " << data_size << " bytes of STE " << (stereo ? "stereo" : "mono")
+              << " audio to " << args[1] << " (" << rate << "Hz)\n";
     return 0;
 }
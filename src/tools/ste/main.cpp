@@ -0,0 +1,151 @@
+#include "BufferStore.hpp"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+
+// Every tool's main(), compiled into this binary under its own name
+#define STE_TOOLS(X)                   \
+    X("st-mkdisk", st_mkdisk_main)     \
+    X("st-boot", st_boot_main)         \
+    X("st-check", st_check_main)       \
+    X("st-defrag", st_defrag_main)     \
+    X("st-dir", st_dir_main)           \
+    X("st-inject", st_inject_main)     \
+    X("st-extract", st_extract_main)   \
+    X("st-rm", st_rm_main)             \
+    X("st-ren", st_ren_main)           \
+    X("st-sync", st_sync_main)         \
+    X("ste-palette", ste_palette_main) \
+    X("st-planar", st_planar_main)     \
+    X("ste-dma-snd", ste_dma_snd_main) \
+    X("st-bin2rsx", st_bin2rsx_main)   \
+    X("pi1-to-png", pi1_to_png_main)   \
+    X("ste-snd-wav", ste_snd_wav_main) \
+    X("st-disasm", st_disasm_main)     \
+    X("st-ym-wav", st_ym_wav_main)
+
+#define DECLARE_TOOL(name, entry) int entry(int argc, char* argv[]);
+STE_TOOLS(DECLARE_TOOL)
+
+struct Tool {
+    std::string_view name;
+    int (*entry)(int, char*[]);
+};
+
+static const Tool kTools[] = {
+#define TOOL_ENTRY(name, entry) { name, entry },
+    STE_TOOLS(TOOL_ENTRY)
+};
+
+// Accepts the full name or the name without its st-/ste- prefix
+static const Tool* find_tool(std::string_view name) {
+    for (const auto& tool : kTools) {
+        if (tool.name == name) return &tool;
+    }
+    for (const auto& tool : kTools) {
+        size_t dash = tool.name.find('-');
+        if (tool.name.starts_with("st") && tool.name.substr(dash + 1) == name) return &tool;
+    }
+    return nullptr;
+}
+
+// Built-in stages moving a whole file between the host and a buffer, so a
+// disk image edited by several stages is read and written only once
+static int run_transfer(const std::vector<std::string>& stage) {
+    bool load = stage[0] == "load";
+    if (stage.size() != 3 || libste::is_buffer_path(stage[1]) == load || libste::is_buffer_path(stage[2]) != load) {
+        std::cerr << "ste: usage: load <file> @name | save @name <file>\n";
+        return 1;
+    }
+    std::vector<uint8_t> storage;
+    std::span<const uint8_t> data;
+    if (!libste::load_input(stage[1], storage, data)) {
+        std::cerr << "ste: cannot read " << stage[1] << "\n";
+        return 1;
+    }
+    if (!libste::save_output(stage[2], data)) {
+        std::cerr << "ste: cannot write " << stage[2] << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+static void print_usage() {
+    std::cout << "Usage: ste <tool> [args...]\n";
+    std::cout << "       ste <tool> [args...] '|' <tool> [args...] ...\n";
+    std::cout << "Stages separated by a '|' argument run in one process. Paths starting\n";
+    std::cout << "with '@' name in-memory buffers shared between the stages, e.g.\n";
+    std::cout << "  ste st-extract game.st TITLE.PI1 @pic '|' pi1-to-png @pic title.png\n";
+    std::cout << "The stages 'load <file> @name' and 'save @name <file>' copy a whole file\n";
+    std::cout << "between the host and a buffer, e.g. to edit a disk image in memory.\n";
+    std::cout << "Tools:";
+    for (const auto& tool : kTools) std::cout << " " << tool.name;
+    std::cout << "\n";
+}
+
+static int run_stage(const Tool& tool, const std::vector<std::string>& args) {
+    std::vector<std::string> storage;
+    storage.emplace_back(tool.name);
+    storage.insert(storage.end(), args.begin(), args.end());
+    std::vector<char*> argv;
+    for (auto& arg : storage) argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    // Tools may leave std::hex and friends set on the shared streams
+    auto out_flags = std::cout.flags();
+    auto err_flags = std::cerr.flags();
+    char out_fill = std::cout.fill();
+    int status = tool.entry(static_cast<int>(storage.size()), argv.data());
+    std::cout.flags(out_flags);
+    std::cout.fill(out_fill);
+    std::cerr.flags(err_flags);
+    std::cout.flush();
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    // Invoked through a symlink named after a tool (BusyBox style)
+    std::string_view self = argv[0];
+    size_t slash = self.find_last_of('/');
+    if (slash != std::string_view::npos) self = self.substr(slash + 1);
+    if (self != "ste" && find_tool(self)) args.insert(args.begin(), std::string(self));
+
+    if (args.empty() || args[0] == "--help" || args[0] == "-h") {
+        print_usage();
+        return args.empty() ? 1 : 0;
+    }
+
+    std::vector<std::vector<std::string>> stages(1);
+    for (auto& arg : args) {
+        if (arg == "|") stages.emplace_back();
+        else stages.back().push_back(arg);
+    }
+
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (stages[i].empty()) {
+            std::cerr << "ste: empty pipeline stage\n";
+            return 1;
+        }
+        if (stages[i][0] == "load" || stages[i][0] == "save") {
+            int status = run_transfer(stages[i]);
+            if (status != 0) return status;
+            continue;
+        }
+        const Tool* tool = find_tool(stages[i][0]);
+        if (!tool) {
+            std::cerr << "ste: unknown tool '" << stages[i][0] << "'\n";
+            return 1;
+        }
+        std::vector<std::string> stage_args(stages[i].begin() + 1, stages[i].end());
+        int status = run_stage(*tool, stage_args);
+        if (status != 0) {
+            if (stages.size() > 1) std::cerr << "ste: stage " << i + 1 << " (" << tool->name << ") failed\n";
+            return status;
+        }
+    }
+    libste::clear_buffers();
+    return 0;
+}